@@ -0,0 +1,216 @@
+/******************************************************************************/
+/*!
+\file   BoardMemory.cpp
+\brief
+This is the implementation file for the huge page allocation behind
+BoardAllocator.
+
+Knight moves jump across the board, so on a board of millions of squares
+nearly every move lands on a page the TLB doesn't hold. Huge pages cover
+2 MB each instead of 4 KB, so the same TLB reaches 512 times as far.
+
+*/
+/******************************************************************************/
+
+#include "BoardMemory.h"
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+//The size of a huge page.
+const std::size_t hugePageSize = 2 << 20;
+//Blocks smaller than a huge page gain nothing from one.
+const std::size_t minHugeAllocation = hugePageSize;
+//Blocks at least this big are faulted in on every core.
+const std::size_t minParallelTouch = 64 << 20;
+
+//The blocks being faulted in right now, on any thread.
+static std::atomic<unsigned> touching( 0 );
+
+/******************************************************************************/
+/*!
+
+Rounds a size up to whole huge pages.
+
+\param bytes
+The size to round.
+
+\return
+The rounded size.
+
+*/
+/******************************************************************************/
+static std::size_t roundToPages( std::size_t bytes )
+{
+	return ( bytes + hugePageSize - 1 ) / hugePageSize * hugePageSize;
+}
+
+/******************************************************************************/
+/*!
+
+Writes to one stretch of the huge pages of a block.
+
+\param memory
+The block.
+
+\param first
+The first page to touch.
+
+\param last
+One past the last page to touch.
+
+*/
+/******************************************************************************/
+static void touchRange( char* memory, std::size_t first, std::size_t last )
+{
+	for( std::size_t page=first; page<last; page++ )
+		memory[ page * hugePageSize ] = 0;
+}
+
+/******************************************************************************/
+/*!
+
+Writes to every page of a block once, split into one stretch per core. The
+kernel zeroes each huge page as it is first written, so a large block is
+cleared by every core at once instead of by the thread that asked for it.
+The calling thread takes the first stretch, and a block that only needs
+one thread is touched by the caller alone.
+
+Racing boards copy their tables at once, each on its own thread, and
+already keep the cores busy. So while another block is being touched, a
+block is touched on its caller's thread, and the racers don't each start
+a thread per core.
+
+The threads aren't pinned, so this says nothing about which NUMA node a
+page ends up on.
+
+\param memory
+The block to touch.
+
+\param bytes
+The size of the block, in whole huge pages.
+
+*/
+/******************************************************************************/
+static void touchPages( char* memory, std::size_t bytes )
+{
+	const std::size_t pages = bytes / hugePageSize;
+	const bool alone = touching++ == 0;
+
+	unsigned threads = std::thread::hardware_concurrency();
+	if( !threads || bytes < minParallelTouch || !alone )
+		threads = 1;
+
+	std::vector<std::thread> touchers;
+	for( unsigned i=1; i<threads; i++ )
+		touchers.push_back( std::thread( touchRange, memory, pages * i / threads, pages * (i + 1) / threads ) );
+
+	touchRange( memory, 0, pages / threads );
+
+	for( unsigned i=0; i<touchers.size(); i++ )
+		touchers[i].join();
+
+	--touching;
+}
+
+/******************************************************************************/
+/*!
+
+Checks if a block is big enough to put on huge pages.
+
+\param bytes
+The size of the block.
+
+\return
+If the block goes on huge pages.
+
+*/
+/******************************************************************************/
+bool IsHugeAllocation(std::size_t bytes)
+{
+	return bytes >= minHugeAllocation;
+}
+
+/******************************************************************************/
+/*!
+
+Allocates a block on huge pages. Explicit huge pages (MAP_HUGETLB) are
+tried first; when the system has none set aside, an ordinary mapping is
+aligned to a huge page and marked for transparent huge pages (MADV_HUGEPAGE)
+instead. Where neither exists, the block comes from operator new, zeroed.
+
+\param bytes
+The size of the block.
+
+\return
+The block. Throws std::bad_alloc when there is no memory.
+
+*/
+/******************************************************************************/
+void* AllocateHugePages(std::size_t bytes)
+{
+	const std::size_t size = roundToPages( bytes );
+
+#ifdef __linux__
+	void* memory = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	memory = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+#endif
+
+	if( memory == MAP_FAILED )
+	{
+		//maps a page more than needed, and trims it down to an aligned block.
+		void* mapped = mmap( 0, size + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		if( mapped == MAP_FAILED )
+			throw std::bad_alloc();
+
+		char* start = static_cast<char*>( mapped );
+		char* aligned = start + ( hugePageSize - reinterpret_cast<std::size_t>( start ) % hugePageSize ) % hugePageSize;
+		if( aligned != start )
+			munmap( start, aligned - start );
+		if( aligned + size != start + size + hugePageSize )
+			munmap( aligned + size, start + size + hugePageSize - ( aligned + size ) );
+
+		memory = aligned;
+#ifdef MADV_HUGEPAGE
+		madvise( memory, size, MADV_HUGEPAGE );
+#endif
+	}
+
+	touchPages( static_cast<char*>( memory ), size );
+	return memory;
+#else
+	void* memory = ::operator new( size );
+	memset( memory, 0, size );
+	return memory;
+#endif
+}
+
+/******************************************************************************/
+/*!
+
+Frees a block from AllocateHugePages.
+
+\param memory
+The block.
+
+\param bytes
+The size the block was allocated with.
+
+*/
+/******************************************************************************/
+void FreeHugePages(void *memory, std::size_t bytes)
+{
+#ifdef __linux__
+	munmap( memory, roundToPages( bytes ) );
+#else
+	(void)bytes;
+	::operator delete( memory );
+#endif
+}
@@ -0,0 +1,81 @@
+/******************************************************************************/
+/*!
+\file   BoardMemory.h
+\brief
+This is the declaration file for BoardAllocator, which can back the tables
+of a GameBoard with huge pages.
+
+*/
+/******************************************************************************/
+
+//---------------------------------------------------------------------------
+#ifndef BOARDMEMORYH
+#define BOARDMEMORYH
+//---------------------------------------------------------------------------
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// Allocates bytes of zeroed memory from huge pages, explicit ones if the
+// system has any set aside and transparent ones otherwise. Large blocks are
+// faulted in by one thread per core, so the kernel zeroes them in parallel,
+// unless another block is being faulted in at the same time.
+void* AllocateHugePages(std::size_t bytes);
+// Frees a block from AllocateHugePages.
+void FreeHugePages(void *memory, std::size_t bytes);
+// False for blocks too small to gain from huge pages.
+bool IsHugeAllocation(std::size_t bytes);
+
+// Hands out ordinary memory, or huge pages when asked to.
+template< class T >
+class BoardAllocator
+{
+  public:
+    typedef T value_type;
+    //a table keeps the pages of the table it is given.
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    explicit BoardAllocator(bool huge = false) : huge_(huge) {}
+    template< class U >
+    BoardAllocator(const BoardAllocator<U>& other) : huge_(other.IsHuge()) {}
+
+    T* allocate(std::size_t count)
+    {
+      const std::size_t bytes = count * sizeof(T);
+      if( huge_ && IsHugeAllocation( bytes ) )
+        return static_cast<T*>( AllocateHugePages( bytes ) );
+      return static_cast<T*>( ::operator new( bytes ) );
+    }
+
+    void deallocate(T *memory, std::size_t count)
+    {
+      const std::size_t bytes = count * sizeof(T);
+      if( huge_ && IsHugeAllocation( bytes ) )
+        FreeHugePages( memory, bytes );
+      else
+        ::operator delete( memory );
+    }
+
+    bool IsHuge(void) const { return huge_; }
+
+  private:
+    bool huge_;
+};
+
+// Memory from one allocator can be freed by another that uses the same pages.
+template< class T, class U >
+bool operator==(const BoardAllocator<T>& lhs, const BoardAllocator<U>& rhs)
+{
+  return lhs.IsHuge() == rhs.IsHuge();
+}
+
+template< class T, class U >
+bool operator!=(const BoardAllocator<T>& lhs, const BoardAllocator<U>& rhs)
+{
+  return !( lhs == rhs );
+}
+
+#endif  // BOARDMEMORYH
@@ -0,0 +1,595 @@
+/******************************************************************************/
+/*!
+\file   BoardRenderer.cpp
+\brief
+This is the implementation file for the class BoardRenderer.
+
+Every square is formatted by hand into a buffer that is written out with
+one fwrite per 64 KB, instead of a printf call or more per square. The
+writing goes through a local pointer rather than a member index, so the
+compiler can keep it in a register across the character stores. Columns
+widen to fit the largest value on the board, so big tours stay aligned.
+
+*/
+/******************************************************************************/
+
+#include "BoardRenderer.h"
+#include <math.h>
+
+//The buffer is written out when it can't take another square.
+const unsigned bufferSize = 1 << 16;
+//The two digits of every number below 100, for writing numbers two digits
+//at a time.
+static const char digitPairs[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+//The narrowest number in a box, and in a flat row.
+const unsigned boxWidth = 3;
+const unsigned flatWidth = 6;
+
+/******************************************************************************/
+/*!
+
+Constructs a renderer.
+
+\param file
+Where the boards are written.
+
+*/
+/******************************************************************************/
+BoardRenderer::BoardRenderer(FILE *file)
+:	file_(file), buffer_(bufferSize)
+{
+}
+
+/******************************************************************************/
+/*!
+
+Nothing is left buffered between boards, so there is nothing to do.
+
+*/
+/******************************************************************************/
+BoardRenderer::~BoardRenderer()
+{
+}
+
+/******************************************************************************/
+/*!
+
+Writes a board of moves or heuristics.
+
+\param board
+The values, row by row. -1 marks a blocked square.
+
+\param rows
+The number of rows in the board.
+
+\param columns
+The number of columns in the board.
+
+\param style
+How the board is laid out.
+
+*/
+/******************************************************************************/
+void BoardRenderer::Render(int const *board, unsigned rows, unsigned columns, RenderStyle style)
+{
+	const unsigned widest = BoardRenderer::widest( board, rows * columns );
+	char *out = &buffer_[0];
+
+	if( style == rsBOXED )
+	{
+		const unsigned width = widest > boxWidth ? widest : boxWidth;
+
+		for( unsigned r=0; r<rows; r++ )
+		{
+			out = putRule( out, columns, width + 2 );
+			out = putBlankRow( out, columns, width + 2 );
+
+			for( unsigned c=0; c<columns; c++ )
+			{
+				out = reserve( out, width + 2 );
+				const int value = board[r * columns + c];
+				*out++ = '|';
+				if( value != -1 )
+					out = putInteger( out, value, width );
+				else
+					out = put( out, ' ', width );
+				*out++ = ' ';
+			}
+			out = reserve( out, 2 );
+			*out++ = '|';
+			*out++ = '\n';
+
+			out = putBlankRow( out, columns, width + 2 );
+		}
+		out = putRule( out, columns, width + 2 );
+	}
+	else
+	{
+		const unsigned width = widest + 1 > flatWidth ? widest + 1 : flatWidth;
+
+		for( unsigned r=0; r<rows; r++ )
+		{
+			for( unsigned c=0; c<columns; c++ )
+			{
+				out = reserve( out, width + 1 );
+				const int value = board[r * columns + c];
+
+				if( style == rsCSV )
+				{
+					if( c )
+						*out++ = ',';
+					if( value != -1 )
+						out = putInteger( out, value, 0 );
+				}
+				else if( value != -1 )
+					out = putInteger( out, value, width );
+				else
+					out = put( out, ' ', width );
+			}
+			out = reserve( out, 1 );
+			*out++ = '\n';
+		}
+	}
+
+	flush( out );
+}
+
+/******************************************************************************/
+/*!
+
+Writes a board of distances.
+
+\param board
+The values, row by row.
+
+\param rows
+The number of rows in the board.
+
+\param columns
+The number of columns in the board.
+
+\param style
+How the board is laid out.
+
+*/
+/******************************************************************************/
+void BoardRenderer::Render(double const *board, unsigned rows, unsigned columns, RenderStyle style)
+{
+	const unsigned decimals = style == rsBOXED ? 1 : 2;
+	char *out = &buffer_[0];
+
+	//the widest whole part sets the width of every value.
+	double largest = 0;
+	for( unsigned i=0; i<rows * columns; i++ )
+		largest = fabs( board[i] ) > largest ? fabs( board[i] ) : largest;
+	const unsigned width = digits( static_cast<long long>( largest + 0.5 ) ) + 1 + decimals;
+
+	if( style == rsBOXED )
+	{
+		for( unsigned r=0; r<rows; r++ )
+		{
+			out = putRule( out, columns, width + 2 );
+			out = putBlankRow( out, columns, width + 2 );
+
+			for( unsigned c=0; c<columns; c++ )
+			{
+				out = reserve( out, width + 2 );
+				*out++ = '|';
+				out = putFixed( out, board[r * columns + c], decimals, width );
+				*out++ = ' ';
+			}
+			out = reserve( out, 2 );
+			*out++ = '|';
+			*out++ = '\n';
+
+			out = putBlankRow( out, columns, width + 2 );
+		}
+		out = putRule( out, columns, width + 2 );
+	}
+	else
+	{
+		for( unsigned r=0; r<rows; r++ )
+		{
+			for( unsigned c=0; c<columns; c++ )
+			{
+				out = reserve( out, width + 2 );
+
+				if( style == rsCSV )
+				{
+					if( c )
+						*out++ = ',';
+					out = putFixed( out, board[r * columns + c], decimals, 0 );
+				}
+				else
+				{
+					*out++ = ' ';
+					out = putFixed( out, board[r * columns + c], decimals, width );
+					*out++ = ' ';
+				}
+			}
+			out = reserve( out, 1 );
+			*out++ = '\n';
+		}
+	}
+
+	flush( out );
+}
+
+/******************************************************************************/
+/*!
+
+Writes a boxed board in the middle of a search, with the square being
+placed or removed marked.
+
+\param board
+The moves, row by row. -1 marks a blocked square.
+
+\param move
+The move being made.
+
+\param rows
+The number of rows in the board.
+
+\param columns
+The number of columns in the board.
+
+\param row
+The row coordinate of the square being placed or removed.
+
+\param column
+The column coordinate of the square being placed or removed.
+
+\param placing
+If the square is being placed (+) or removed (-).
+
+*/
+/******************************************************************************/
+void BoardRenderer::RenderMove(int const *board, unsigned move, unsigned rows, unsigned columns,
+                               unsigned row, unsigned column, bool placing)
+{
+	const unsigned widest = BoardRenderer::widest( board, rows * columns );
+	const unsigned moveWidth = digits( move );
+	unsigned width = widest > moveWidth ? widest : moveWidth;
+	width = width > boxWidth ? width : boxWidth;
+
+	const char sign = placing ? '+' : '-';
+	char *out = &buffer_[0];
+
+	for( unsigned r=0; r<rows; r++ )
+	{
+		out = putRule( out, columns, width + 2 );
+		out = putBlankRow( out, columns, width + 2 );
+
+		for( unsigned c=0; c<columns; c++ )
+		{
+			out = reserve( out, width + 2 );
+			const int value = board[r * columns + c];
+			const bool marked = r == row && c == column;
+
+			*out++ = '|';
+			if( value != -1 )
+				out = putInteger( out, value, width );
+			else if( marked )
+				out = putInteger( out, move, width );
+			else
+				out = put( out, ' ', width );
+			*out++ = marked ? sign : ' ';
+		}
+		out = reserve( out, 2 );
+		*out++ = '|';
+		*out++ = '\n';
+
+		out = putBlankRow( out, columns, width + 2 );
+	}
+	out = putRule( out, columns, width + 2 );
+
+	flush( out );
+}
+
+/******************************************************************************/
+/*!
+
+Makes room for bytes more characters, writing out the buffer if it is too
+full to take them.
+
+\param out
+Where the next character goes.
+
+\param bytes
+The characters about to be added.
+
+\return
+Where the next character goes now.
+
+*/
+/******************************************************************************/
+char* BoardRenderer::reserve(char *out, unsigned bytes)
+{
+	if( out + bytes > &buffer_[0] + buffer_.size() )
+	{
+		flush( out );
+		return &buffer_[0];
+	}
+
+	return out;
+}
+
+/******************************************************************************/
+/*!
+
+Writes out the buffer.
+
+\param out
+The end of what has been added.
+
+*/
+/******************************************************************************/
+void BoardRenderer::flush(char *out)
+{
+	if( out != &buffer_[0] )
+		fwrite( &buffer_[0], 1, out - &buffer_[0], file_ );
+}
+
+/******************************************************************************/
+/*!
+
+Adds a character count times.
+
+\param out
+Where the first one goes.
+
+\param c
+The character.
+
+\param count
+How many times.
+
+\return
+The end of what was added.
+
+*/
+/******************************************************************************/
+char* BoardRenderer::put(char *out, char c, unsigned count)
+{
+	for( unsigned i=0; i<count; i++ )
+		*out++ = c;
+
+	return out;
+}
+
+/******************************************************************************/
+/*!
+
+Adds a whole number, right-aligned.
+
+\param out
+Where it goes.
+
+\param value
+The number.
+
+\param width
+The fewest characters it takes, padded with spaces on the left.
+
+\return
+The end of what was added.
+
+*/
+/******************************************************************************/
+char* BoardRenderer::putInteger(char *out, long long value, unsigned width)
+{
+	//the digits come out last first, two at a time.
+	char text[24];
+	char *first = text + sizeof(text);
+	unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+
+	while( magnitude >= 100 )
+	{
+		const unsigned pair = static_cast<unsigned>( magnitude % 100 ) * 2;
+		magnitude /= 100;
+		*--first = digitPairs[pair + 1];
+		*--first = digitPairs[pair];
+	}
+	if( magnitude >= 10 )
+	{
+		*--first = digitPairs[magnitude * 2 + 1];
+		*--first = digitPairs[magnitude * 2];
+	}
+	else
+		*--first = static_cast<char>( '0' + magnitude );
+
+	if( value < 0 )
+		*--first = '-';
+
+	const unsigned length = static_cast<unsigned>( text + sizeof(text) - first );
+	if( width > length )
+		out = put( out, ' ', width - length );
+
+	while( first != text + sizeof(text) )
+		*out++ = *first++;
+
+	return out;
+}
+
+/******************************************************************************/
+/*!
+
+Adds a number with a fixed count of decimals, right-aligned.
+
+\param out
+Where it goes.
+
+\param value
+The number.
+
+\param decimals
+The digits after the point, at most 6.
+
+\param width
+The fewest characters it takes, padded with spaces on the left.
+
+\return
+The end of what was added.
+
+*/
+/******************************************************************************/
+char* BoardRenderer::putFixed(char *out, double value, unsigned decimals, unsigned width)
+{
+	unsigned long long scale = 1;
+	for( unsigned i=0; i<decimals; i++ )
+		scale *= 10;
+
+	const unsigned long long scaled = static_cast<unsigned long long>( fabs( value ) * scale + 0.5 );
+	const unsigned long long whole = scaled / scale;
+	unsigned long long fraction = scaled % scale;
+
+	const unsigned length = digits( whole ) + ( decimals ? decimals + 1 : 0 ) + ( value < 0 ? 1 : 0 );
+	if( width > length )
+		out = put( out, ' ', width - length );
+
+	if( value < 0 )
+		*out++ = '-';
+	out = putInteger( out, static_cast<long long>( whole ), 0 );
+
+	if( decimals )
+	{
+		*out++ = '.';
+		for( unsigned i=decimals; i>0; i-- )
+		{
+			out[i - 1] = static_cast<char>( '0' + fraction % 10 );
+			fraction /= 10;
+		}
+		out += decimals;
+	}
+
+	return out;
+}
+
+/******************************************************************************/
+/*!
+
+Counts the characters a whole number takes.
+
+\param value
+The number.
+
+\return
+Its digits, and its sign if it is negative.
+
+*/
+/******************************************************************************/
+unsigned BoardRenderer::digits(long long value)
+{
+	unsigned count = value < 0 ? 2 : 1;
+	unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+
+	while( magnitude >= 10 )
+	{
+		magnitude /= 10;
+		++count;
+	}
+
+	return count;
+}
+
+/******************************************************************************/
+/*!
+
+Finds the characters the widest value on a board takes.
+
+\param board
+The values. -1 marks a blocked square, which is left out.
+
+\param size
+The number of values.
+
+\return
+The characters of the widest value.
+
+*/
+/******************************************************************************/
+unsigned BoardRenderer::widest(int const *board, unsigned size)
+{
+	unsigned width = 1;
+
+	for( unsigned i=0; i<size; i++ )
+	{
+		if( board[i] != -1 )
+		{
+			const unsigned length = digits( board[i] );
+			width = length > width ? length : width;
+		}
+	}
+
+	return width;
+}
+
+/******************************************************************************/
+/*!
+
+Adds the line of dashes above and below each row of boxes.
+
+\param out
+Where it goes.
+
+\param columns
+The number of columns in the board.
+
+\param width
+The characters each box takes, its left side included.
+
+\return
+The end of what was added.
+
+*/
+/******************************************************************************/
+char* BoardRenderer::putRule(char *out, unsigned columns, unsigned width)
+{
+	for( unsigned c=0; c<columns; c++ )
+	{
+		out = reserve( out, width );
+		out = put( out, '-', width );
+	}
+	out = reserve( out, 2 );
+	*out++ = '-';
+	*out++ = '\n';
+
+	return out;
+}
+
+/******************************************************************************/
+/*!
+
+Adds the empty line above and below the values in a row of boxes.
+
+\param out
+Where it goes.
+
+\param columns
+The number of columns in the board.
+
+\param width
+The characters each box takes, its left side included.
+
+\return
+The end of what was added.
+
+*/
+/******************************************************************************/
+char* BoardRenderer::putBlankRow(char *out, unsigned columns, unsigned width)
+{
+	for( unsigned c=0; c<columns; c++ )
+	{
+		out = reserve( out, width );
+		*out++ = '|';
+		out = put( out, ' ', width - 1 );
+	}
+	out = reserve( out, 2 );
+	*out++ = '|';
+	*out++ = '\n';
+
+	return out;
+}
@@ -0,0 +1,68 @@
+/******************************************************************************/
+/*!
+\file   BoardRenderer.h
+\brief
+This is the declaration file for the class BoardRenderer, which prints
+boards a row at a time through one reusable buffer.
+
+*/
+/******************************************************************************/
+
+//---------------------------------------------------------------------------
+#ifndef BOARDRENDERERH
+#define BOARDRENDERERH
+//---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <vector>
+
+class BoardRenderer
+{
+  public:
+    enum RenderStyle
+    {
+      rsBOXED, // every square in a box three lines high
+      rsFLAT,  // one line per row, right-aligned columns
+      rsCSV    // one line per row, comma separated, blocked squares empty
+    };
+
+      // Writes to file, stdout by default.
+    BoardRenderer(FILE *file = stdout);
+    ~BoardRenderer();
+
+      // Moves or heuristics, row by row (-1 is blocked).
+    void Render(int const *board, unsigned rows, unsigned columns, RenderStyle style);
+      // Distances, row by row. Boxed squares show one decimal, the others two.
+    void Render(double const *board, unsigned rows, unsigned columns, RenderStyle style);
+      // A boxed board in the middle of a search, with row,column marked + when
+      // placing and - when removing. A blocked square there shows move.
+    void RenderMove(int const *board, unsigned move, unsigned rows, unsigned columns,
+                    unsigned row, unsigned column, bool placing);
+
+  private:
+    FILE *file_;
+    std::vector<char> buffer_;
+
+    //makes room for bytes more characters at out, writing the buffer out
+    //first if it can't take them, and returns where to carry on.
+    char* reserve(char *out, unsigned bytes);
+    //writes the buffer out up to out.
+    void flush(char *out);
+
+    //add text at out, and return the end of it.
+    static char* put(char *out, char c, unsigned count);
+    static char* putInteger(char *out, long long value, unsigned width);
+    static char* putFixed(char *out, double value, unsigned decimals, unsigned width);
+
+    //the characters value takes.
+    static unsigned digits(long long value);
+
+    //the widest value on a board, blocked squares left out.
+    static unsigned widest(int const *board, unsigned size);
+
+    //the lines between and inside the rows of boxes.
+    char* putRule(char *out, unsigned columns, unsigned width);
+    char* putBlankRow(char *out, unsigned columns, unsigned width);
+};
+
+#endif  // BOARDRENDERERH
@@ -15,13 +15,215 @@ of the classes GameBoard, Search, and Space.
 /******************************************************************************/
 
 #include "GameBoard.h"
+#include "TourRules.h"
 #include <math.h>
+#include <stdio.h>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <bit>
 
 //No magic numbers in my house.
 const int longWay = 2;
 const int shortWay = 1;
 const unsigned numMoves = 8;
 
+//The displacement values of an (S,L)-leaper with eight moves, in the order
+//the knight has always used. Instantiated for the common leapers, so their
+//neighbor lists are built from constants.
+template< int S, int L >
+struct Leaper
+{
+	static const unsigned count = numMoves;
+	static const int rJump[numMoves];
+	static const int cJump[numMoves];
+};
+
+template< int S, int L >
+const int Leaper<S,L>::rJump[numMoves] = { -S, -L, -L, -S, +S, +L, +L, +S };
+template< int S, int L >
+const int Leaper<S,L>::cJump[numMoves] = { +L, +S, -S, -L, -L, -S, +S, +L };
+
+typedef Leaper< shortWay, longWay > Knight;
+typedef Leaper< 1, 3 > Camel;
+typedef Leaper< 2, 3 > Zebra;
+typedef Leaper< 1, 4 > Giraffe;
+
+//The displacement values of any other leaper. Leapers with a zero or two
+//equal sides only have four different moves.
+struct Leap
+{
+	unsigned count;
+	int rJump[numMoves];
+	int cJump[numMoves];
+
+	Leap( const unsigned& shortLeap, const unsigned& longLeap )
+	:	count(0), rJump(), cJump()
+	{
+		const int s = static_cast<int>(shortLeap);
+		const int l = static_cast<int>(longLeap);
+		const int rows[numMoves] = { -s, -l, -l, -s, +s, +l, +l, +s };
+		const int columns[numMoves] = { +l, +s, -s, -l, -l, -s, +s, +l };
+
+		for( unsigned i=0; i<numMoves; i++ )
+		{
+			bool repeated = rows[i] == 0 && columns[i] == 0;
+			for( unsigned j=0; j<count; j++ )
+				repeated = repeated || ( rJump[j] == rows[i] && cJump[j] == columns[i] );
+
+			if( repeated )
+				continue;
+
+			rJump[count] = rows[i];
+			cJump[count] = columns[i];
+			++count;
+		}
+	}
+};
+
+//Restart budgets are multiples of this many moves per square.
+const unsigned budgetPerSquare = 2;
+
+//Marks that no square has been forced to be the end of the tour.
+const unsigned noIndex = ~0u;
+
+//Where a square is on a repaired path when it isn't: still to be placed,
+//or held back for the end.
+const unsigned offPath = ~0u;
+const unsigned heldOff = ~0u - 1;
+
+//Repairs give up after placing or moving this many squares per square,
+//and this many more.
+const unsigned repairWorkPerSquare = 16;
+const unsigned repairWorkExtra = 1 << 20;
+
+//The most rotations in a row a repair looks for at once, and the most ends
+//of the path it looks at to find them.
+const unsigned repairDepth = 16;
+const unsigned repairReach = 1024;
+
+//How much of the old tour a repair first searches again either side of the
+//changes, and how much more each time that fails.
+const unsigned repairMargin = 64;
+const unsigned repairGrowth = 8;
+
+//Snapshots start with this, then their version.
+const unsigned checkpointMagic = 0x4B4E5453;
+const unsigned checkpointVersion = 4;
+
+const unsigned GameBoard::maxEndgame;
+const unsigned GameBoard::maxMoves;
+
+//Regions remembered at once, a power of two. A region takes the place of
+//whichever it hashes alongside.
+const unsigned maxEndgameMemo = 1 << 16;
+
+//The sides of a tile, when the board is stored in tiles.
+const unsigned tileSize = 16;
+
+//The largest distance rank a cell holds.
+const unsigned maxRank = (1u << 24) - 1;
+
+/******************************************************************************/
+/*!
+
+Scrambles a 64-bit value (splitmix64). Used to turn a seed into a
+generator state.
+
+\param value
+The value to scramble.
+
+\return
+The scrambled value.
+
+*/
+/******************************************************************************/
+static unsigned long long mixSeed( unsigned long long value )
+{
+	value += 0x9E3779B97F4A7C15ULL;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+	return value ^ (value >> 31);
+}
+
+/******************************************************************************/
+/*!
+
+Lists the squares of one block of a board in Z-order (Morton order): the
+top left quarter, then the top right, the bottom left and the bottom right,
+each in the same order. This is the order of the squares' codes with the
+bits of the row and column interleaved, the column's lowest. Quarters off
+the board are skipped, so every square is listed once, in order, without
+working out or sorting the codes.
+
+\param rows
+The rows of the board.
+
+\param columns
+The columns of the board.
+
+\param top
+The top row of the block.
+
+\param left
+The left column of the block.
+
+\param side
+The side of the block, a power of two.
+
+\param order
+Receives the row-major index of each square.
+
+*/
+/******************************************************************************/
+template< class Order >
+static void listMorton( const unsigned& rows, const unsigned& columns, unsigned long long top,
+                        unsigned long long left, unsigned long long side, Order& order )
+{
+	if( top >= rows || left >= columns )
+		return;
+
+	if( side == 1 )
+	{
+		order.push_back( static_cast<unsigned>( (top*columns)+left ) );
+		return;
+	}
+
+	side /= 2;
+	listMorton( rows, columns, top, left, side, order );
+	listMorton( rows, columns, top, left + side, side, order );
+	listMorton( rows, columns, top + side, left, side, order );
+	listMorton( rows, columns, top + side, left + side, side, order );
+}
+
+/******************************************************************************/
+/*!
+
+Returns the i'th term of the Luby sequence 1,1,2,1,1,2,4,1,1,2,...
+
+\param i
+The term to return, starting at 1.
+
+\return
+The value of the term.
+
+*/
+/******************************************************************************/
+static unsigned luby( unsigned i )
+{
+	for( ;; )
+	{
+		unsigned k = 1;
+		while( ((1u << k) - 1) < i )
+			++k;
+
+		if( ((1u << k) - 1) == i )
+			return 1u << (k - 1);
+
+		i -= (1u << (k - 1)) - 1;
+	}
+}
+
 /******************************************************************************/
 /*!
 
@@ -153,50 +355,60 @@ Search::Search( const GameBoard* gameboard )
 /******************************************************************************/
 /*!
 
-Compares two Spaces based on the gameboard_ policy_ member.
+Compares two squares by CompareCandidates, with the tie-breaks of the
+gameboard_ policy_ member.
 
 \param lhs
-The left hand Space to compare.
+The 1-D index of the left hand square to compare.
 
 \param rhs
-The right hand Space to compare.
+The 1-D index of the right hand square to compare.
 
 \return
 Which element to prioritize.
 
 */
 /******************************************************************************/
-bool Search::operator()( const Space& lhs, const Space& rhs ) const
+bool Search::operator()( const unsigned& lhs, const unsigned& rhs ) const
 {
 	//arranges them reverse than how they are fed.
 	if( gameboard_->GetTourPolicy() == GameBoard::tpSTATIC ) return leftHasPriority;
 
-	const unsigned leftIndex = gameboard_->get1DIndex( lhs.getRow(), lhs.getColumn() );
-	const unsigned rightIndex = gameboard_->get1DIndex( rhs.getRow(), rhs.getColumn() );
+	//one cell holds both the heuristic and the distance of a square.
+	const GameBoard::Cell& left = gameboard_->cells_[lhs];
+	const GameBoard::Cell& right = gameboard_->cells_[rhs];
 
-	const int* heuristicsBoard = gameboard_->GetHTable();
-	const int leftHeuristic = heuristicsBoard[leftIndex];
-	const int rightHeuristic = heuristicsBoard[rightIndex];
+	const auto lookahead = [this, &lhs, &rhs]()
+	{
+		//Pohl's rule: the lower second-level degree sum goes first. The sums
+		//are read off the board, which is back as it was when the queue was
+		//built whenever the queue is touched.
+		if( gameboard_->GetTourPolicy() == GameBoard::tpLOOKAHEAD )
+		{
+			const int leftSum = gameboard_->getLookahead( lhs );
+			const int rightSum = gameboard_->getLookahead( rhs );
+			if( leftSum != rightSum )
+				return leftSum < rightSum ? -1 : 1;
+		}
 
-	const double* distanceBoard = gameboard_->GetDTable();
-	const double leftDistance = distanceBoard[leftIndex];
-	const double rightDistance = distanceBoard[rightIndex];
+		return 0;
+	};
 
-	//If heuristic value is the same, then check distance value.
-	if( leftHeuristic==rightHeuristic )
+	const int order = CompareCandidates( left.degree, left.rank, right.degree, right.rank, lookahead, [this, &lhs, &rhs]()
 	{
-		//If distance of left is greater or equal, left has priority.
-		if( leftDistance >= rightDistance )
-			return leftHasPriority;
-		//Otherwise, right has priority.
-		return rightHasPriority;
-	}
-	//Otherwise, if left side has a lower heuristic, left has priority.
-	else if( leftHeuristic<rightHeuristic )
-		return leftHasPriority;
+		//Restarted tours settle whatever is left with the seeded random table.
+		if( gameboard_->IsRandomized() )
+		{
+			const unsigned* randomBoard = &gameboard_->randomBoard_[0];
+			if( randomBoard[lhs] < randomBoard[rhs] )
+				return 1;
+		}
+
+		return 0;
+	} );
 
-	//Otherwise, right side has priority.
-	return rightHasPriority;
+	//the square that goes first has priority, and left keeps it on a tie.
+	return order > 0 ? rightHasPriority : leftHasPriority;
 }
 
 /******************************************************************************/
@@ -213,27 +425,73 @@ The total number of columns in the board.
 \param callback
 A function to call suring the KnightsTour() function.
 
+\param mask
+One flag per square, row by row, false where the square can't be used.
+Null uses every square.
+
+\param shortLeap
+The short side of the piece's leap.
+
+\param longLeap
+The long side of the piece's leap.
+
+\param layout
+How the squares are stored. Tiles and Z-order keep the squares a move apart
+closer in memory on large boards.
+
+\param hugePages
+If the cells, neighbor lists and the other tables the search reads are put
+on huge pages, so fewer TLB entries cover them.
+
 */
 /******************************************************************************/
-GameBoard::GameBoard(unsigned rows, unsigned columns, KNIGHTS_CALLBACK callback)
-:	rows_(rows), columns_(columns), callback_(callback), message_(MSG_PLACING)
+GameBoard::GameBoard(unsigned rows, unsigned columns, KNIGHTS_CALLBACK callback, bool const *mask,
+                     unsigned shortLeap, unsigned longLeap, BoardLayout layout, bool hugePages)
+:	rows_(rows), columns_(columns), callback_(callback), policy_(tpSTATIC), layout_(layout), totalMoves_(0), iteration_(0),
+	shortLeap_(shortLeap < longLeap ? shortLeap : longLeap), longLeap_(shortLeap < longLeap ? longLeap : shortLeap),
+	message_(MSG_PLACING), boardCurrent_(false), aborted_(false), moveBudget_(~0u), stop_(0),
+	checkpointMoves_(0), nextCheckpoint_(~0u), endgameSquares_(0), freeCount_(0), randomized_(false), seed_(0),
+	randomState_(0), stepped_(false), stepTour_(false), endIndex_(noIndex)
 {
 	size_ = rows_*columns_ ;
+
+	//every table takes its pages from the same allocator.
+	const BoardAllocator<unsigned> pages( hugePages );
+	cells_ = Table<Cell>( pages );
+	storageIndex_ = Table<unsigned>( pages );
+	rowIndex_ = Table<unsigned>( pages );
+	neighborStart_ = Table<unsigned>( pages );
+	neighbors_ = Table<unsigned>( pages );
+	randomBoard_ = Table<unsigned>( pages );
+
+	setLayout();
+
+	if( shortLeap_ == 1 && longLeap_ == 2 )
+		setNeighbors( mask, Knight() );
+	else if( shortLeap_ == 1 && longLeap_ == 3 )
+		setNeighbors( mask, Camel() );
+	else if( shortLeap_ == 2 && longLeap_ == 3 )
+		setNeighbors( mask, Zebra() );
+	else if( shortLeap_ == 1 && longLeap_ == 4 )
+		setNeighbors( mask, Giraffe() );
+	else
+		setNeighbors( mask, Leap( shortLeap_, longLeap_ ) );
+
+	setMoveBoard();
+	setHeuristicsBoard();
 	setDistanceBoard();
 }
 
 /******************************************************************************/
 /*!
 
-Clears the three boards.
+Clears the boards.
 
 */
 /******************************************************************************/
 GameBoard::~GameBoard( void )
 {
-	moveBoard_.clear();
-	heuristicsBoard_.clear();
-	distanceBoard_.clear();
+	cells_.clear();
 }
 
 /******************************************************************************/
@@ -254,265 +512,394 @@ A type of search to perform.
 /******************************************************************************/
 bool GameBoard::KnightsTour(unsigned row, unsigned column, TourPolicy policy)
 {
-	//resets the boards on first iteration and sets the policy member.
-
 	//resets total moves performed 
 	totalMoves_ = 0;
-	//resets to move 1, the first iteration.
-	iteration_ = 1;
 	//sets the determinant policy
 	policy_ = policy;
-	//The first piece is placed down.
-	message_ = MSG_PLACING;
-
-	//resets the movement board.
-	setMoveBoard();
-	//resets the heuristics board.
-	setHeuristicsBoard();
-
-	//starts the tour, retrives the result.
-	bool tour = PlaceKnight( row, column );
+	//nobody has asked to stop yet.
+	aborted_ = false;
+	//a single search runs until it is done.
+	moveBudget_ = ~0u;
+	randomized_ = false;
+	//the first snapshot is a full interval away.
+	nextCheckpoint_ = checkpoint_.empty() || !checkpointMoves_ ? ~0u : checkpointMoves_;
+
+	bool tour = false;
+
+	//starts the tour, retrives the result. Boards with no tour aren't searched.
+	if( isTourPossible( row, column, true ) )
+		tour = startTour( row, column );
+	else
+		rejectTour( row, column );
 
 	//call the callback function to see what the final status was.
-	callback_( *this, &moveBoard_[0], message_, totalMoves_, rows_, columns_, currentSpace.getRow(), currentSpace.getColumn() );
+	if( callback_ )
+		callback_( *this, &boardView_[0], message_, totalMoves_, rows_, columns_, currentSpace.getRow(), currentSpace.getColumn() );
 
 	//If queue is empty, but no end has been reached, return false.
 	return tour;
 }
 
-bool GameBoard::PlaceKnight( const unsigned& row, const unsigned& column )
-{
-	//increases the move counter.
-	++totalMoves_;
+/******************************************************************************/
+/*!
 
-	//Get the 1-D index of the 2-D coordinates.
-	unsigned index = get1DIndex( row, column );
+Searches for a tour from row,column with ties broken by a seeded generator.
+Every attempt is given a move budget of a Luby-sequence multiple of the
+board size, and is abandoned for a freshly seeded one once the budget runs
+out. The same seed always gives the same attempts. With more than one
+thread, each thread restarts from its own seed (seed, seed+1, ...) and the
+first tour found stops the others; GetSeed() then names the winning seed.
 
-	//Set the piece on the movement board.
-	moveBoard_[index] = iteration_;
+\param row
+The row coordinate of the space given.
 
-	//have all the spots on the board been reached?
-	if( isSolved() )
-	{
-		//set the callback message.
-		message_ = MSG_FINISHED_OK;
-		return true;
-	}
+\param column
+The column coordinate of the space given.
 
-	//get the next available moves.
-	MoveContainer nextMoves = getNextAvailable( row, column );
+\param policy
+A type of search to perform.
 
-	//while the queue is not empty,
-	while( !nextMoves.empty() )
-	{
-		//increment current move
-		++iteration_;
+\param seed
+Seeds the tie-breaking generator.
 
-		//take the top and call this function.
-		currentSpace = nextMoves.top();
+\param threads
+The number of seeds to race.
 
-		//call the callback function.
-		callback_( *this, &moveBoard_[0], message_, totalMoves_, rows_, columns_, row, column );
+\param attempts
+The number of attempts each seed gets before giving up.
 
-		message_ = MSG_PLACING;
+\return
+If a tour was found or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::KnightsTourRestarts(unsigned row, unsigned column, TourPolicy policy,
+                                    unsigned long long seed, unsigned threads, unsigned attempts)
+{
+	totalMoves_ = 0;
+	policy_ = policy;
+	aborted_ = false;
+	seed_ = seed;
+	randomState_ = mixSeed( seed );
+
+	bool tour = false;
+
+	if( !isTourPossible( row, column, true ) )
+	{
+		rejectTour( row, column );
+	}
+	else if( threads <= 1 )
+	{
+		tour = restartTours( row, column, attempts );
+	}
+	else
+	{
+		std::atomic<bool> stop( false );
+		std::atomic<int> winner( -1 );
 
-		if( PlaceKnight(currentSpace.getRow(), currentSpace.getColumn() ) )
+		//every racer gets its own copy of the board, and no callback. Each
+		//copy is made on its racer's thread, so the copies are made at once.
+		std::vector< std::unique_ptr<GameBoard> > boards( threads );
+		std::vector<std::thread> racers;
+
+		for( unsigned i=0; i<threads; i++ )
 		{
-			//if iteration returns true, return true.
-			return true;
+			racers.push_back( std::thread( [this, &boards, &stop, &winner, seed, row, column, attempts, i]()
+			{
+				boards[i].reset( new GameBoard( *this ) );
+
+				GameBoard& board = *boards[i];
+				board.callback_ = 0;
+				board.stop_ = &stop;
+				board.seed_ = seed + i;
+				board.randomState_ = mixSeed( board.seed_ );
+
+				if( board.restartTours( row, column, attempts ) )
+				{
+					int none = -1;
+					if( winner.compare_exchange_strong( none, static_cast<int>(i) ) )
+						stop = true;
+				}
+			} ) );
 		}
-		//otherwise, move was a dead end. Undo some operations.
-		else
-		{
-			//pop the last space off the stack
-			nextMoves.pop();
 
-			//decrement current move
-			--iteration_;
+		for( unsigned i=0; i<threads; i++ )
+			racers[i].join();
 
-			message_ = MSG_REMOVING;
+		//the total is what every racer spent, the board is the winner's.
+		for( unsigned i=0; i<threads; i++ )
+			totalMoves_ += boards[i]->totalMoves_;
 
-			//get the index of the space that was last used.
-			const unsigned nextIndex = get1DIndex( currentSpace.getRow(), currentSpace.getColumn());
-			//remove the move off the movement board.
-			moveBoard_[nextIndex] = 0;
-			//reset the wrong space's heuristic. 
-			++heuristicsBoard_[nextIndex];
-		}
+		const int won = winner;
+		tour = won >= 0;
 
+		const GameBoard& best = *boards[ tour ? won : 0 ];
+		cells_ = best.cells_;
+		//brings the callback's copy up to date.
+		boardCurrent_ = false;
+		GetBoard();
+		currentSpace = best.currentSpace;
+		seed_ = best.seed_;
+		message_ = tour ? MSG_FINISHED_OK : MSG_FINISHED_FAIL;
 	}
 
-	//The queue is empty and the board is not solved. This is a dead end.
-	message_ = MSG_FINISHED_FAIL;
-	return false;
+	//call the callback function to see what the final status was.
+	if( callback_ )
+		callback_( *this, &boardView_[0], message_, totalMoves_, rows_, columns_, currentSpace.getRow(), currentSpace.getColumn() );
+
+	return tour;
 }
 
 /******************************************************************************/
 /*!
 
-Returns the number of moves performed
+Has KnightsTour snapshot its search to a file every so many moves, and
+when the callback stops it. A snapshot holds the squares of the tour so
+far, the moves each of them has left to try, the heuristics and the
+counters, which is all KnightsTourResume needs to carry on. Restarted
+tours are not snapshotted.
 
-\return
-The number of total moves performed.
+\param path
+The file to write, or 0 to stop snapshotting.
+
+\param moves
+The number of moves between snapshots. 0 only snapshots when stopped.
 
 */
 /******************************************************************************/
-unsigned GameBoard::GetMoves(void) const        // the number of moves made
+void GameBoard::SetCheckpoint(const char *path, unsigned moves)
 {
-	return totalMoves_;
+	checkpoint_ = path ? path : "";
+	checkpointMoves_ = moves;
 }
 
 /******************************************************************************/
 /*!
 
-Returns the TourPolicy member
+Carries on a search snapshotted by KnightsTour on a board made the same
+way, from exactly where the snapshot was taken. The search then goes on as
+if it had never been stopped, with the same moves, callbacks and counts.
+
+\param path
+The snapshot to resume.
 
 \return
-The type of search being used.
+If a tour was found or not. False if the snapshot can't be read or was
+taken on another board.
 
 */
 /******************************************************************************/
-GameBoard::TourPolicy GameBoard::GetTourPolicy(void) const // the policy used to search
+bool GameBoard::KnightsTourResume(const char *path)
 {
-	return policy_;
-}
+	aborted_ = false;
+	moveBudget_ = ~0u;
+	randomized_ = false;
 
-/******************************************************************************/
-/*!
+	std::vector<Frame> frames;
+	if( !readCheckpoint( path, frames ) )
+	{
+		message_ = MSG_FINISHED_FAIL;
+		return false;
+	}
 
-Returns the Movement board
+	nextCheckpoint_ = checkpoint_.empty() || !checkpointMoves_ || totalMoves_ >= ~0u - checkpointMoves_ ?
+		~0u : totalMoves_ + checkpointMoves_;
+	stepped_ = false;
+	stepTour_ = false;
 
-\return
-The movement board.
+	//puts back the stack of frames down to the snapshot, and goes on from there.
+	frames_.swap( frames );
+	bool tour = runSteps( ssPLACED );
+	frames_.clear();
 
-*/
-/******************************************************************************/
-int const *GameBoard::GetBoard(void) const
-{
-	return &moveBoard_[0];
+	//call the callback function to see what the final status was.
+	if( callback_ )
+		callback_( *this, &boardView_[0], message_, totalMoves_, rows_, columns_, currentSpace.getRow(), currentSpace.getColumn() );
+
+	return tour;
 }
 
 /******************************************************************************/
 /*!
 
-Returns the heuristics board
+Turns a tour found before the board changed into a tour of the board as it
+is now: with squares blocked or freed by the mask, from another start, or
+to a given end. Rather than searching again, the old tour is kept in the
+longest stretches that are still moves, and only the gaps between them are
+searched.
+
+Only the part of the old tour between the first and the last change is
+searched, with a margin either side: the tour before it is kept as it was,
+and the tour after it is held back, to be joined on at the end. If that
+fails, the margin grows eight times over, and last of all the whole tour is
+searched. A new start is searched from whichever end of the old tour is
+nearer it.
+
+Within that part, the path follows the old tour wherever it still can. When
+it can't, it moves to the square off the path with the fewest moves left
+and takes the longest stretch of the old tour beyond it. When its end has no
+square off the path left to go to, the path is rotated (Posa): for a move
+from the end to a square earlier on the path, the part after that square is
+reversed, which gives the path a new end without losing any square. Up to
+16 rotations in a row are looked for, breadth first, before a stretch left
+off the path is spliced in between two squares a move from its ends, or the
+path is cut back to make room for a square nothing else reaches.
+
+Each try gives up once it has placed and moved 16 squares per square it
+searches. GetMoves counts those squares, and not the old tour kept either
+side. A failed repair isn't proof that there is no tour; KnightsTour can
+still be run.
+
+\param tour
+The old tour, row by row, as GetBoard() gave it. Any square may be
+missing, blocked or out of order; only moves from one move number to the
+next that are still moves on this board are kept.
 
-\return
-The heuristics board.
+\param row
+The row coordinate of the start.
 
-*/
-/******************************************************************************/
-int const *GameBoard::GetHTable(void) const
-{
-	return &heuristicsBoard_[0];
-}
+\param column
+The column coordinate of the start.
 
-/******************************************************************************/
-/*!
+\param endRow
+The row coordinate of the end, ~0u for any end.
 
-Returns the distance board
+\param endColumn
+The column coordinate of the end, ~0u for any end.
 
 \return
-The distance board.
+If a tour was found or not.
 
 */
 /******************************************************************************/
-double const *GameBoard::GetDTable(void) const // 1-D representation of distance table
+bool GameBoard::KnightsTourRepair(int const *tour, unsigned row, unsigned column, unsigned endRow, unsigned endColumn)
 {
-	return &distanceBoard_[0];
-}
-
+	totalMoves_ = 0;
+	aborted_ = false;
+	moveBudget_ = ~0u;
+	randomized_ = false;
 
-/******************************************************************************/
-/*!
+	const bool ended = endRow != noIndex || endColumn != noIndex;
+	bool possible = isTourPossible( row, column, false ) && ( !ended || isEndPossible( row, column, endRow, endColumn ) );
+	bool repaired = false;
 
-Sets the values in the movement board to 0.
+	const unsigned start = possible ? get1DIndex( row, column ) : noIndex;
+	unsigned end = possible && ended ? get1DIndex( endRow, endColumn ) : noIndex;
 
-*/
-/******************************************************************************/
-void GameBoard::setMoveBoard( void )
-{
-	moveBoard_.clear();
-	moveBoard_.reserve( size_);
+	//a square with only one move has to be the end.
+	for( unsigned k=0; k<loneSquares_.size() && possible && !ended && squares_ > 2; k++ )
+	{
+		const unsigned i = loneSquares_[k];
+		if( i != start && neighborStart_[i+1] - neighborStart_[i] == 1 )
+		{
+			const Space space = get2DSpace( i );
+			possible = isEndPossible( row, column, space.getRow(), space.getColumn() );
+			end = i;
+			break;
+		}
+	}
 
-	for( unsigned i=0; i<size_; i++ )
+	if( possible )
 	{
-		moveBoard_.push_back( 0 );
+		currentSpace( row, column );
+		repaired = repairTour( tour, start, end );
 	}
+	else
+		rejectTour( row, column );
+
+	message_ = repaired ? MSG_FINISHED_OK : MSG_FINISHED_FAIL;
+
+	//call the callback function to see what the final status was.
+	if( callback_ )
+		callback_( *this, &boardView_[0], message_, totalMoves_, rows_, columns_, currentSpace.getRow(), currentSpace.getColumn() );
+
+	return repaired;
 }
 
 /******************************************************************************/
 /*!
 
-Sets the values in the heuristics board based on its size.
+Has the search finish tours exactly once only a few squares are left,
+rather than backtracking through them move by move. Warnsdorff's rule tends
+to go wrong near the end of a tour, and backtracking out of those last few
+dozen squares can take exponentially long; a region that small is instead
+solved outright, and the answer kept for the next time the search leaves
+the same squares.
+
+\param squares
+The most squares to finish exactly, 0 to turn it off. No more than 20.
 
 */
 /******************************************************************************/
-void GameBoard::setHeuristicsBoard( void )
+void GameBoard::SetEndgame(unsigned squares)
 {
-	heuristicsBoard_.clear();
-	heuristicsBoard_.reserve( size_ );
+	endgameSquares_ = squares < maxEndgame ? squares : maxEndgame;
+}
+
+/******************************************************************************/
+/*!
 
-	const unsigned options[3][3] = {{ 2, 3, 4 },
-									{ 3, 4, 6 },
-									{ 4, 6, 8 }};
+Resets the boards and searches for a tour from row,column, without the
+final callback.
 
-	const unsigned* optionRow;
-	const unsigned* option;
+\param row
+The row coordinate of the space given.
 
-	for( unsigned i=0; i<rows_; i++ )
-	{
-		if( i==0 || i==(rows_-1) )
-			optionRow = &options[0][0];	
-		else if( i==1 || i==(rows_-2) )
-			optionRow = &options[1][0];
-		else
-			optionRow = &options[2][0];
+\param column
+The column coordinate of the space given.
 
-		for( unsigned j=0; j<columns_; j++ )
-		{
-			if( j==0 || j==(columns_-1) )
-				option = optionRow;	
-			else if( j==1 || j==(columns_-2) )
-				option = (optionRow+1);
-			else
-				option = (optionRow+2);
+\return
+If a tour was found or not.
 
-			heuristicsBoard_.push_back( *option );
-		}
-	}
+*/
+/******************************************************************************/
+bool GameBoard::startTour( const unsigned& row, const unsigned& column )
+{
+	resetTour();
+
+	//starts the tour, retrives the result.
+	const bool tour = runSteps( placeStep( get1DIndex( row, column ) ) );
+
+	//boards copied for racing don't copy the search.
+	frames_.clear();
+	return tour;
 }
 
 /******************************************************************************/
 /*!
 
-Sets the values in the distance board based on a positions distance from center.
+Resets the boards and counters for a search about to place its first
+square.
 
 */
 /******************************************************************************/
-void GameBoard::setDistanceBoard( void )
+void GameBoard::resetTour( void )
 {
-	distanceBoard_.clear();
-	distanceBoard_.reserve( size_ );
-
-	for( unsigned i=0; i<rows_; i++ )
-	{
-		const double y = static_cast<int>(i) - (static_cast<double>(rows_-1)/2.0);
-
-		for( unsigned j=0; j<columns_; j++ )
-		{
-			const double x = static_cast<int>(j) - (static_cast<double>(columns_-1)/2.0);
+	//resets to move 1, the first iteration.
+	iteration_ = 1;
+	//The first piece is placed down.
+	message_ = MSG_PLACING;
+	//nothing is forced yet.
+	endIndex_ = noIndex;
 
-			const double distance = sqrt( (x*x) + (y*y) );
-			distanceBoard_.push_back( distance );
-		}
-	}
+	//resets the movement board.
+	setMoveBoard();
+	//resets the heuristics board.
+	setHeuristicsBoard();
+	//the random board is only filled in as candidates are found.
+	if( randomized_ )
+		randomBoard_.assign( size_, 0 );
+	//one frame per move, run to the end.
+	stepped_ = false;
+	stepTour_ = false;
+	frames_.clear();
+	frames_.reserve( squares_ );
 }
 
 /******************************************************************************/
 /*!
 
-Finds the next available spaces, adds them if available, and sorts them based on policy.
+Resets the boards and sets the failure message without searching.
 
 \param row
 The row coordinate of the space given.
@@ -520,37 +907,2913 @@ The row coordinate of the space given.
 \param column
 The column coordinate of the space given.
 
-\return
-The next moves possible in their order.
-
 */
 /******************************************************************************/
-const GameBoard::MoveContainer GameBoard::getNextAvailable( const unsigned& row, const unsigned& column )
+void GameBoard::rejectTour( const unsigned& row, const unsigned& column )
 {
-	  
-	Search search( this );
-	MoveContainer nextMoves( search );
+	setMoveBoard();
+	setHeuristicsBoard();
 
-	// Holds the displacement values.
-	const int rJump[] = { -shortWay, -longWay, -longWay, -shortWay, +shortWay, +longWay, +longWay, +shortWay };
-	const int cJump[] = { +longWay, +shortWay, -shortWay, -longWay, -longWay, -shortWay, +shortWay, +longWay };
+	currentSpace( row, column );
+	message_ = MSG_FINISHED_FAIL;
+}
 
-	for( unsigned i=0; i<numMoves; i++ )
-	{
-		Space space( row+rJump[i], column+cJump[i] );
-		//If the space is available on the board, we place it on the nextMove queue.
-		if( isAvailable(space) )
+/******************************************************************************/
+/*!
+
+Decides whether a knight's tour can exist at all, without searching.
+
+An open tour on an m x n board (m <= n) exists exactly when m = n = 1,
+m = 3 and n = 4 or n >= 7, m = 4 and n >= 5, or m >= 5 (Conrad et al.).
+A closed tour exists unless m and n are both odd, m is 1, 2 or 4, or
+m = 3 and n is 4, 6 or 8 (Schwenk).
+
+A knight always changes colour, so a tour on a board with an odd number of
+squares has to start and end on the colour of the corners. Closed tours
+don't exist on those boards, and start anywhere on the rest.
+
+Other starts that fail on 3 x n and 4 x n boards are left to the search, so
+a true result doesn't promise a tour, but a false one rules it out.
+
+\param rows
+The total number of rows in the board.
+
+\param columns
+The total number of columns in the board.
+
+\param row
+The row coordinate of the start.
+
+\param column
+The column coordinate of the start.
+
+\param closed
+If the tour has to end a knight's move from the start.
+
+\return
+If a tour might exist or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::IsTourPossible(unsigned rows, unsigned columns, unsigned row, unsigned column, bool closed)
+{
+	//the start has to be on the board.
+	if( row >= rows || column >= columns )
+		return false;
+
+	const unsigned m = rows < columns ? rows : columns;
+	const unsigned n = rows < columns ? columns : rows;
+
+	if( closed )
+	{
+		if( (m % 2) && (n % 2) )
+			return false;
+		if( m == 1 || m == 2 || m == 4 )
+			return false;
+		return !( m == 3 && ( n == 4 || n == 6 || n == 8 ) );
+	}
+
+	bool shape = false;
+	if( m == 1 )
+		shape = n == 1;
+	else if( m == 3 )
+		shape = n == 4 || n >= 7;
+	else if( m == 4 )
+		shape = n >= 5;
+	else
+		shape = m >= 5;
+
+	if( !shape )
+		return false;
+
+	//odd boards start on the corners' colour.
+	if( (m % 2) && (n % 2) )
+		return (row + column) % 2 == 0;
+
+	return true;
+}
+
+/******************************************************************************/
+/*!
+
+Decides whether a tour from row,column can exist on this board. Full boards
+toured by a knight use IsTourPossible. Otherwise:
+
+ - a leaper whose sides add up to an odd number always changes colour, so
+   the open squares of the two colours can differ by at most one, and if
+   they differ the tour starts on the colour with more. Any other leaper
+   never changes colour, so every open square has to be the start's colour.
+ - a square with no moves can't be on a tour of more than one square.
+ - a square with one move has to be an end of the tour, so there can't be
+   more than two, and if there are two the tour starts on one of them.
+ - every open square has to be reachable from the start.
+
+\param row
+The row coordinate of the start.
+
+\param column
+The column coordinate of the start.
+
+\param walk
+If the board is walked from the start to check the last rule. Repairs
+skip the walk, which would cost a pass over the whole board; on a board
+split in two they fail like any other repair that finds no tour.
+
+\return
+If a tour might exist or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::isTourPossible( const unsigned& row, const unsigned& column, const bool& walk ) const
+{
+	if( !masked_ && shortLeap_ == shortWay && longLeap_ == longWay )
+		return IsTourPossible( rows_, columns_, row, column );
+
+	if( row >= rows_ || column >= columns_ || blocked_[ get1DIndex( row, column ) ] )
+		return false;
+
+	const unsigned start = (row + column) % 2 ? oddSquares_ : evenSquares_;
+	const unsigned other = (row + column) % 2 ? evenSquares_ : oddSquares_;
+
+	if( (shortLeap_ + longLeap_) % 2 )
+	{
+		if( start != other && start != other + 1 )
+			return false;
+	}
+	else if( other )
+	{
+		return false;
+	}
+
+	const unsigned startIndex = get1DIndex( row, column );
+	unsigned ends = 0;
+	bool startIsEnd = false;
+
+	for( unsigned k=0; k<loneSquares_.size(); k++ )
+	{
+		const unsigned i = loneSquares_[k];
+		const unsigned degree = neighborStart_[i+1] - neighborStart_[i];
+
+		if( degree == 0 && squares_ > 1 )
+			return false;
+
+		if( degree == 1 )
+		{
+			++ends;
+			startIsEnd = startIsEnd || i == startIndex;
+		}
+	}
+
+	if( ends > 2 || ( ends == 2 && !startIsEnd ) )
+		return false;
+
+	if( !walk )
+		return true;
+
+	//walks the neighbor lists from the start.
+	std::vector<bool> reached( size_, false );
+	std::vector<unsigned> frontier( 1, startIndex );
+	unsigned count = 1;
+	reached[startIndex] = true;
+
+	while( !frontier.empty() )
+	{
+		const unsigned index = frontier.back();
+		frontier.pop_back();
+
+		for( unsigned i=neighborStart_[index]; i<neighborStart_[index+1]; i++ )
+		{
+			if( !reached[ neighbors_[i] ] )
+			{
+				reached[ neighbors_[i] ] = true;
+				frontier.push_back( neighbors_[i] );
+				++count;
+			}
+		}
+	}
+
+	return count == squares_;
+}
+
+/******************************************************************************/
+/*!
+
+Runs randomized attempts with Luby-sequence move budgets until one of them
+finds a tour, the attempts run out, or the search is stopped.
+
+\param row
+The row coordinate of the space given.
+
+\param column
+The column coordinate of the space given.
+
+\param attempts
+The most attempts to make.
+
+\return
+If a tour was found or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::restartTours( const unsigned& row, const unsigned& column, const unsigned& attempts )
+{
+	randomized_ = true;
+
+	const unsigned long long unit = static_cast<unsigned long long>(budgetPerSquare) * size_;
+	bool tour = false;
+
+	for( unsigned attempt=1; attempt<=attempts && !tour; attempt++ )
+	{
+		if( aborted_ || ( stop_ && *stop_ ) )
+			break;
+
+		unsigned long long budget = totalMoves_ + unit * luby( attempt );
+		moveBudget_ = budget < ~0u ? static_cast<unsigned>(budget) : ~0u;
+
+		tour = startTour( row, column );
+	}
+
+	randomized_ = false;
+	moveBudget_ = ~0u;
+
+	if( !tour )
+		message_ = MSG_FINISHED_FAIL;
+
+	return tour;
+}
+
+/******************************************************************************/
+/*!
+
+Decides whether a tour from row,column could end on endRow,endColumn. The
+end has to be an open square other than the start, and a leaper that
+always changes colour ends on the start's colour exactly when the tour has
+an odd number of squares.
+
+\param row
+The row coordinate of the start.
+
+\param column
+The column coordinate of the start.
+
+\param endRow
+The row coordinate of the end.
+
+\param endColumn
+The column coordinate of the end.
+
+\return
+If such a tour might exist or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::isEndPossible( const unsigned& row, const unsigned& column, const unsigned& endRow, const unsigned& endColumn ) const
+{
+	if( endRow >= rows_ || endColumn >= columns_ || blocked_[ get1DIndex( endRow, endColumn ) ] )
+		return false;
+
+	if( endRow == row && endColumn == column )
+		return squares_ == 1;
+
+	if( (shortLeap_ + longLeap_) % 2 )
+		return ( (row + column) % 2 == (endRow + endColumn) % 2 ) == ( squares_ % 2 == 1 );
+
+	return true;
+}
+
+/******************************************************************************/
+/*!
+
+Repairs an old tour into a path from start through every square, as
+KnightsTourRepair describes, and puts it on the move board. Reading the old
+tour and writing the board are the only passes over every square; the rest
+is bounded by the parts searched again.
+
+\param tour
+The old tour, row by row.
+
+\param start
+The 1-D index of the start.
+
+\param end
+The 1-D index of the end, or noIndex for any end.
+
+\return
+If a tour was found or not. A failed repair leaves the path it had grown.
+
+*/
+/******************************************************************************/
+bool GameBoard::repairTour( int const* tour, const unsigned& start, const unsigned& end )
+{
+	//the old tour's squares in the order it took them, and where each one is
+	//in it.
+	std::vector<unsigned> old( size_, noIndex );
+	std::vector<unsigned> place( size_ );
+	for( unsigned i=0; i<size_; i++ )
+	{
+		const unsigned index = layout_ == blROWS ? i : storageIndex_[i];
+		const bool numbered = tour[i] > 0 && static_cast<unsigned>(tour[i]) <= size_;
+
+		place[index] = numbered ? static_cast<unsigned>(tour[i] - 1) : noIndex;
+		if( numbered )
+			old[ tour[i] - 1 ] = index;
+	}
+
+	//a tour that skips or repeats a number is closed up.
+	unsigned count = size_;
+	if( std::find( old.begin(), old.end(), noIndex ) != old.end() )
+	{
+		std::fill( place.begin(), place.end(), noIndex );
+		count = 0;
+		for( unsigned k=0; k<size_; k++ )
+		{
+			if( old[k] != noIndex )
+			{
+				place[ old[k] ] = count;
+				old[ count++ ] = old[k];
+			}
+		}
+		old.resize( count );
+	}
+
+	//the open squares the old tour missed, if it missed any.
+	std::vector<unsigned> extra;
+	for( unsigned i=0; i<size_ && count < size_; i++ )
+	{
+		if( place[i] == noIndex && !( masked_ && blocked_[i] ) )
+			extra.push_back( i );
+	}
+
+	unsigned changedLow = 0;
+	unsigned changedHigh = 0;
+	findDisruption( old, place, extra, changedLow, changedHigh );
+
+	unsigned low = changedLow;
+	unsigned high = changedHigh;
+	coverEnds( old, place, start, end, false, low, high );
+
+	//a new start near the old end is nearer the start of the old tour taken
+	//backwards.
+	if( count && old[0] != start )
+	{
+		unsigned backLow = count - changedHigh;
+		unsigned backHigh = count - changedLow;
+		coverEnds( old, place, start, end, true, backLow, backHigh );
+
+		if( backHigh - backLow < high - low )
+		{
+			low = backLow;
+			high = backHigh;
+
+			std::reverse( old.begin(), old.end() );
+			for( unsigned k=0; k<count; k++ )
+				place[ old[k] ] = k;
+		}
+	}
+
+	//the old tour is searched again a little either side of the changes,
+	//then more and more of it, and last of all as a whole. Until then it all
+	//stays where it was. The buffers a try reads are set for the squares it
+	//searches as it starts, so they are left as they come here.
+	RepairPath path;
+	path.squares.reserve( squares_ );
+	path.position.swap( place );
+	path.links = std::make_unique_for_overwrite<unsigned[]>( 2 * static_cast<size_t>(size_) );
+	path.listed = std::make_unique_for_overwrite<unsigned char[]>( size_ );
+	path.mark = std::make_unique_for_overwrite<unsigned[]>( size_ );
+	path.work = 0;
+	path.stamp = 0;
+	path.floor = count;
+	path.ceiling = count;
+	bool repaired = false;
+
+	for( unsigned margin=repairMargin; ; margin*=repairGrowth )
+	{
+		unsigned first = low > margin ? low - margin : 0;
+		unsigned last = count - high > margin ? high + margin : count;
+		//an unchanged end is still searched for, if only as itself.
+		if( low >= high )
+		{
+			first = last = count;
+			if( end != noIndex )
+				--first;
+		}
+
+		const bool whole = first == 0 && last == count;
+		repaired = repairSpan( path, old, extra, start, end, first, last, whole );
+
+		if( repaired || whole )
+			break;
+	}
+
+	//the path, then the old tour it held back, go on the board in the order
+	//the squares are stored.
+	const unsigned length = static_cast<unsigned>(path.squares.size());
+	for( unsigned i=0; i<size_; i++ )
+	{
+		const unsigned at = placeOnPath( path, i );
+
+		if( masked_ && blocked_[i] )
+			cells_[i].move = -1;
+		else if( at < heldOff )
+			cells_[i].move = static_cast<int>(at + 1);
+		else if( at == heldOff && repaired )
+			cells_[i].move = static_cast<int>(length + path.position[i] - path.ceiling + 1);
+		else
+			cells_[i].move = 0;
+	}
+
+	boardCurrent_ = false;
+	setFreeSquares();
+	if( callback_ )
+		GetBoard();
+
+	totalMoves_ = path.work < ~0u ? static_cast<unsigned>(path.work) : ~0u;
+	iteration_ = static_cast<int>(repaired ? squares_ : length);
+
+	return repaired;
+}
+
+/******************************************************************************/
+/*!
+
+Finds the part of the old tour that has to change wherever the tour starts
+and ends: the squares now blocked, the moves that are no longer moves, and
+the squares a move from any the old tour missed.
+
+\param old
+The old tour's squares in order.
+
+\param place
+Where each square is in old, or noIndex.
+
+\param extra
+The open squares not in old.
+
+\param low
+Set to the first place in old that has to change, or the size of old if
+none does.
+
+\param high
+Set to one past the last place in old that has to change, or 0 if none
+does.
+
+*/
+/******************************************************************************/
+void GameBoard::findDisruption( const std::vector<unsigned>& old, const std::vector<unsigned>& place, const std::vector<unsigned>& extra,
+                                unsigned& low, unsigned& high ) const
+{
+	const unsigned count = static_cast<unsigned>(old.size());
+	low = count;
+	high = 0;
+
+	//each square is found on the board once, for the moves either side of it.
+	Space at = count ? get2DSpace( old[0] ) : Space();
+	for( unsigned k=0; k<count; k++ )
+	{
+		const bool open = !( masked_ && blocked_[ old[k] ] );
+		bool linked = false;
+
+		if( k + 1 < count )
+		{
+			const Space next = get2DSpace( old[k+1] );
+			linked = !( masked_ && blocked_[ old[k+1] ] ) && isLeap( at, next );
+			at = next;
+		}
+
+		if( !open || ( k + 1 < count && !linked ) )
+		{
+			low = std::min( low, k );
+			high = std::max( high, std::min( k + 2, count ) );
+		}
+	}
+
+	//squares the old tour didn't take go in next to their neighbors.
+	for( unsigned i=0; i<extra.size(); i++ )
+	{
+		const unsigned square = extra[i];
+		bool placed = false;
+
+		for( unsigned j=neighborStart_[square]; j<neighborStart_[square+1]; j++ )
+		{
+			const unsigned at = place[ neighbors_[j] ];
+			if( at != noIndex )
+			{
+				low = std::min( low, at );
+				high = std::max( high, at + 1 );
+				placed = true;
+			}
+		}
+
+		if( !placed )
+		{
+			low = 0;
+			high = count;
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Adds a new start and end to the part of the old tour that has to change,
+taking the old tour one way or the other: a new start is searched from
+where it is (and all before it), and a new end up to where it is (and all
+after it).
+
+\param old
+The old tour's squares in order, taken forwards.
+
+\param place
+Where each square is in old, or noIndex.
+
+\param start
+The 1-D index of the start.
+
+\param end
+The 1-D index of the end, or noIndex for any end.
+
+\param backward
+If the old tour is taken backwards. low and high count from its old end.
+
+\param low
+The first place that has to change, set to the first with the ends. Set
+to the size of old if none does.
+
+\param high
+One past the last place that has to change, set to one past the last with
+the ends. Set to the size of old if none does.
+
+*/
+/******************************************************************************/
+void GameBoard::coverEnds( const std::vector<unsigned>& old, const std::vector<unsigned>& place, const unsigned& start,
+                           const unsigned& end, const bool& backward, unsigned& low, unsigned& high ) const
+{
+	const unsigned count = static_cast<unsigned>(old.size());
+	const unsigned oldStart = count ? old[ backward ? count - 1 : 0 ] : noIndex;
+	const unsigned oldEnd = count ? old[ backward ? 0 : count - 1 ] : noIndex;
+
+	//a square the old tour missed is already covered with the rest of them.
+	for( unsigned i=0; i<2; i++ )
+	{
+		const unsigned square = i ? end : start;
+		if( square == noIndex || square == ( i ? oldEnd : oldStart ) || place[square] == noIndex )
+			continue;
+
+		const unsigned at = backward ? count - 1 - place[square] : place[square];
+		low = std::min( low, at );
+		high = std::max( high, at + 1 );
+	}
+
+	if( start != oldStart )
+		low = 0;
+	if( end != noIndex && end != oldEnd )
+		high = count;
+
+	if( low >= high )
+		low = high = count;
+}
+
+/******************************************************************************/
+/*!
+
+Searches again one part of the old tour, keeping the rest: the squares
+before it stay as they were at the start of the path, and the squares
+after it are held back and joined on at the end.
+
+\param path
+The path to grow. The work it has done so far is kept.
+
+\param old
+The old tour's squares in order.
+
+\param extra
+The open squares not in old.
+
+\param start
+The 1-D index of the start.
+
+\param end
+The 1-D index of the end, or noIndex for any end.
+
+\param first
+The first place in old searched again.
+
+\param last
+One past the last place in old searched again.
+
+\param whole
+If this is the last try, with the whole board searched.
+
+\return
+If a tour was found or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::repairSpan( RepairPath& path, const std::vector<unsigned>& old, const std::vector<unsigned>& extra,
+                            const unsigned& start, const unsigned& end, const unsigned& first, const unsigned& last, const bool& whole )
+{
+	const unsigned count = static_cast<unsigned>(old.size());
+
+	//the squares searched again come off the path, and the old tour's moves
+	//through them that are still moves are kept. The squares either side
+	//are linked to them too. The rest of the path was left as it was by the
+	//last, smaller try, and the rest of the old tour keeps its places in it.
+	const unsigned before = first ? first - 1 : first;
+	const unsigned after = last < count ? last + 1 : last;
+
+	for( unsigned k=before; k<after + extra.size(); k++ )
+	{
+		const unsigned square = k < after ? old[k] : extra[ k - after ];
+		if( k >= first && ( k < last || k >= after ) )
+			path.position[square] = offPath;
+		path.listed[square] = 0;
+		path.mark[square] = 0;
+		path.links[ 2 * square ] = noIndex;
+		path.links[ 2 * square + 1 ] = noIndex;
+	}
+
+	for( unsigned k=first ? first - 1 : 0; k+1<count && k<last; k++ )
+	{
+		const unsigned from = old[k];
+		const unsigned to = old[k+1];
+
+		if( !( masked_ && ( blocked_[from] || blocked_[to] ) ) && isLeap( from, to ) )
+		{
+			path.links[ 2 * from + 1 ] = to;
+			path.links[ 2 * to ] = from;
+		}
+	}
+
+	if( path.squares.size() > first )
+		path.squares.resize( first );
+	for( unsigned k=static_cast<unsigned>(path.squares.size()); k<first; k++ )
+		path.squares.push_back( old[k] );
+
+	path.floor = first;
+	path.ceiling = last;
+
+	//the same choices every time.
+	randomState_ = mixSeed( first ^ ( static_cast<unsigned long long>(last) << 32 ) );
+
+	//the rest of the old tour, or just the end, is held back until
+	//everything else is on the path.
+	unsigned target = noIndex;
+	unsigned held = 0;
+	if( last < count )
+	{
+		target = old[last];
+		held = count - last;
+	}
+	else if( end != noIndex )
+	{
+		target = end;
+		held = 1;
+		path.position[end] = heldOff;
+	}
+
+	const unsigned placed = squares_ - held;
+
+	//the squares that may still be off the path.
+	path.loose.clear();
+	for( unsigned i=first; i<last + extra.size(); i++ )
+	{
+		const unsigned square = i < last ? old[i] : extra[ i - last ];
+
+		if( path.position[square] == offPath && !( masked_ && blocked_[square] ) )
+		{
+			path.loose.push_back( square );
+			path.listed[square] = 1;
+		}
+	}
+
+	const unsigned window = static_cast<unsigned>(path.loose.size()) + 1;
+	const unsigned long long budget = path.work + static_cast<unsigned long long>(repairWorkPerSquare) * ( whole ? squares_ : window ) +
+	                                  ( whole ? repairWorkExtra : 0 );
+
+	if( path.squares.empty() )
+		appendStretch( path, start, true );
+
+	std::vector<unsigned>& loose = path.loose;
+
+	for( ;; )
+	{
+		const unsigned at = path.squares.back();
+
+		if( path.squares.size() == placed && ( target == noIndex || isLeap( at, target ) ) )
+			break;
+
+		if( path.work > budget )
+			return false;
+
+		//everything else is on: the end of the path has to be brought next to
+		//the held squares.
+		if( path.squares.size() == placed )
+		{
+			if( !rotatePath( path, target, true ) )
+				ejectPath( path, target );
+			continue;
+		}
+
+		//the old tour is followed where it goes on, and otherwise the square
+		//off the path with the fewest moves left goes next, the ends of old
+		//stretches before the middles.
+		unsigned best = nextLink( path, at, noIndex );
+		unsigned bestScore = ~0u;
+
+		for( unsigned i=neighborStart_[at]; i<neighborStart_[at+1] && best == noIndex; i++ )
+		{
+			const unsigned next = neighbors_[i];
+			if( path.position[next] != offPath )
+				continue;
+
+			const unsigned back = nextLink( path, next, noIndex );
+			const bool middle = back != noIndex && nextLink( path, next, back ) != noIndex;
+			const unsigned score = countOffPath( path, next ) + ( middle ? numMoves + 1 : 0 );
+
+			if( score < bestScore )
+			{
+				best = next;
+				bestScore = score;
+			}
+		}
+
+		//a stretch cut in two is taken the shorter way, so the path's end stays
+		//near the rest of it.
+		if( best != noIndex )
+		{
+			appendStretch( path, best, false );
+			continue;
+		}
+
+		//stretches left behind are spliced in wherever the path passes both
+		//their ends. A stretch that won't go is tried once a pass.
+		const unsigned pass = ++path.stamp;
+		unsigned spliced = 0;
+		unsigned kept = 0;
+
+		for( unsigned i=0; i<loose.size(); i++ )
+		{
+			const unsigned square = loose[i];
+
+			if( path.position[square] == offPath && path.mark[square] != pass )
+			{
+				if( spliceStretch( path, square ) )
+					++spliced;
+				else
+				{
+					for( unsigned j=0; j<path.stretch.size(); j++ )
+						path.mark[ path.stretch[j] ] = pass;
+				}
+			}
+
+			//only part of its stretch may have gone in.
+			if( path.position[square] == offPath )
+				loose[kept++] = square;
+			else
+				path.listed[square] = 0;
+		}
+		loose.resize( kept );
+
+		if( spliced )
+			continue;
+
+		//every square off the path is listed, so this can't happen; but
+		//it can't be searched from either.
+		if( loose.empty() )
+			return false;
+
+		//then the end of the path is moved to reach them, and failing that
+		//the path is cut back to one of them, which goes on next.
+		if( !rotatePath( path, noIndex, false ) )
+		{
+			const unsigned square = loose[ nextRandom() % loose.size() ];
+			ejectPath( path, square );
+		}
+	}
+
+	//the rest of the old tour stays where it was, after the path.
+	if( last == count && target != noIndex )
+	{
+		path.position[target] = static_cast<unsigned>(path.squares.size());
+		path.squares.push_back( target );
+	}
+
+	return true;
+}
+
+/******************************************************************************/
+/*!
+
+Splices a piece of the stretch of the old tour through a square off the
+path into the path. The piece has to run from a move from one square on the
+path to a move from another, later one. Between two squares next to each
+other it just goes in; otherwise the squares between the two are reversed
+around it, which needs the squares after each (or before each) to be a move
+apart, unless the later one is the end of the path. The longest piece that
+fits, from either end of the stretch, is spliced in, and the rest of the
+stretch is left for later.
+
+\param path
+The path being repaired.
+
+\param index
+The 1-D index of a square off the path.
+
+\return
+If any of the stretch was spliced in.
+
+*/
+/******************************************************************************/
+bool GameBoard::spliceStretch( RepairPath& path, const unsigned& index )
+{
+	//finds one end of the stretch, then lists it from there.
+	unsigned from = noIndex;
+	unsigned first = index;
+	for( unsigned next = nextLink( path, first, from ); next != noIndex; next = nextLink( path, first, from ) )
+	{
+		from = first;
+		first = next;
+	}
+
+	std::vector<unsigned>& stretch = path.stretch;
+	stretch.clear();
+	from = noIndex;
+	for( unsigned at = first; at != noIndex; )
+	{
+		stretch.push_back( at );
+		const unsigned next = nextLink( path, at, from );
+		from = at;
+		at = next;
+	}
+
+	const unsigned length = static_cast<unsigned>(path.squares.size());
+	const unsigned count = static_cast<unsigned>(stretch.size());
+	path.work += count;
+
+	//the best splice: the places on the path the piece goes between, how it
+	//is made, which end of the stretch it starts from, and how long it is.
+	unsigned bestLow = 0;
+	unsigned bestHigh = 0;
+	unsigned bestWay = 0;
+	bool bestFromBack = false;
+	unsigned bestCount = 0;
+
+	for( unsigned side=0; side<2 && bestCount<count; side++ )
+	{
+		//the places on the path a move from this end of the stretch.
+		const unsigned end = side ? stretch[count-1] : stretch[0];
+		unsigned lows[numMoves];
+		unsigned lowCount = 0;
+
+		for( unsigned i=neighborStart_[end]; i<neighborStart_[end+1]; i++ )
+		{
+			const unsigned low = placeOnPath( path, neighbors_[i] );
+			if( low < heldOff && low + 1 >= path.floor )
+				lows[lowCount++] = low;
+		}
+
+		//the longest piece whose other end is a move from a later square.
+		for( unsigned n=count; n>bestCount && lowCount; n-- )
+		{
+			const unsigned other = side ? stretch[count-n] : stretch[n-1];
+
+			for( unsigned j=neighborStart_[other]; j<neighborStart_[other+1] && bestCount<n; j++ )
+			{
+				const unsigned high = placeOnPath( path, neighbors_[j] );
+				if( high >= heldOff )
+					continue;
+
+				for( unsigned i=0; i<lowCount; i++ )
+				{
+					const unsigned low = lows[i];
+					if( high <= low )
+						continue;
+
+					//1 goes straight in, 2 reverses the squares between up to the
+					//end, 3 reverses them when the squares after are a move apart,
+					//4 when the squares before are.
+					unsigned way = 0;
+					if( high == low + 1 )
+						way = 1;
+					else if( high + 1 == length )
+						way = 2;
+					else if( isLeap( path.squares[low+1], path.squares[high+1] ) )
+						way = 3;
+					else if( low > 0 && low >= path.floor && isLeap( path.squares[low-1], path.squares[high-1] ) )
+						way = 4;
+
+					if( way )
+					{
+						bestLow = low;
+						bestHigh = high;
+						bestWay = way;
+						bestFromBack = side != 0;
+						bestCount = n;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	if( !bestCount )
+		return false;
+
+	//the piece, from the square a move from bestLow's to the one a move from bestHigh's.
+	std::vector<unsigned> piece( bestCount );
+	for( unsigned n=0; n<bestCount; n++ )
+		piece[n] = bestFromBack ? stretch[count-1-n] : stretch[n];
+
+	std::vector<unsigned>& squares = path.squares;
+	unsigned changed = bestLow + 1;
+
+	if( bestWay == 1 )
+		squares.insert( squares.begin() + bestLow + 1, piece.begin(), piece.end() );
+	else if( bestWay == 4 )
+	{
+		//low-1, high-1 ... low, piece, high ...
+		std::reverse( squares.begin() + bestLow, squares.begin() + bestHigh );
+		squares.insert( squares.begin() + bestHigh, piece.begin(), piece.end() );
+		changed = bestLow;
+	}
+	else
+	{
+		//low, piece, high ... low+1, high+1 ...
+		std::reverse( squares.begin() + bestLow + 1, squares.begin() + bestHigh + 1 );
+		squares.insert( squares.begin() + bestLow + 1, piece.begin(), piece.end() );
+	}
+
+	for( unsigned i=changed; i<squares.size(); i++ )
+		path.position[ squares[i] ] = i;
+
+	path.work += squares.size() - changed;
+	return true;
+}
+
+/******************************************************************************/
+/*!
+
+Follows the old tour one square on from index, away from the square it was
+reached from.
+
+\param path
+The path being repaired.
+
+\param index
+The 1-D index of the square.
+
+\param from
+The 1-D index of the square before it, or noIndex.
+
+\return
+The next square of the old tour that is still off the path, or noIndex.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::nextLink( const RepairPath& path, const unsigned& index, const unsigned& from ) const
+{
+	for( unsigned side=0; side<2; side++ )
+	{
+		const unsigned next = path.links[ 2 * index + side ];
+		if( next != noIndex && next != from && path.position[next] == offPath )
+			return next;
+	}
+
+	return noIndex;
+}
+
+/******************************************************************************/
+/*!
+
+Picks which way to follow the old tour from a square in the middle of a
+stretch off the path. Both ways are walked a square at a time until one of
+them ends, so this costs twice the shorter way.
+
+\param path
+The path being repaired.
+
+\param index
+The 1-D index of the square.
+
+\param longer
+If the longer way is wanted, rather than the shorter.
+
+\return
+The first square of the way chosen, or noIndex if there is none.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::chooseLink( const RepairPath& path, const unsigned& index, const bool& longer ) const
+{
+	const unsigned back = nextLink( path, index, noIndex );
+	const unsigned ahead = back == noIndex ? noIndex : nextLink( path, index, back );
+
+	if( ahead == noIndex )
+		return back;
+
+	unsigned backFrom = index;
+	unsigned aheadFrom = index;
+	unsigned backAt = back;
+	unsigned aheadAt = ahead;
+
+	for( ;; )
+	{
+		const unsigned backNext = nextLink( path, backAt, backFrom );
+		const unsigned aheadNext = nextLink( path, aheadAt, aheadFrom );
+
+		//the way that runs out first is the shorter.
+		if( aheadNext == noIndex )
+			return longer ? back : ahead;
+		if( backNext == noIndex )
+			return longer ? ahead : back;
+
+		backFrom = backAt;
+		backAt = backNext;
+		aheadFrom = aheadAt;
+		aheadAt = aheadNext;
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Puts a square on the end of the path, then the stretch of the old tour
+that follows it, one way or the other.
+
+\param path
+The path being repaired.
+
+\param index
+The 1-D index of the square.
+
+\param longer
+If the longer way along the old tour is taken, rather than the shorter.
+
+*/
+/******************************************************************************/
+void GameBoard::appendStretch( RepairPath& path, const unsigned& index, const bool& longer )
+{
+	unsigned from = index;
+	unsigned next = chooseLink( path, index, longer );
+
+	path.position[index] = static_cast<unsigned>(path.squares.size());
+	path.squares.push_back( index );
+	++path.work;
+
+	while( next != noIndex )
+	{
+		path.position[next] = static_cast<unsigned>(path.squares.size());
+		path.squares.push_back( next );
+		++path.work;
+
+		const unsigned after = nextLink( path, next, from );
+		from = next;
+		next = after;
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Rotates the path on a move from its end back to an earlier square: the
+squares after that one are reversed, so the square just after it becomes
+the end (Posa). An end that can go on (to a square off the path, or to
+target) is looked for first in one rotation anywhere along the path, taking
+the one that moves the fewest squares, then in more rotations in a row.
+Nothing before the path's floor is moved.
+
+\param path
+The path being repaired.
+
+\param target
+The 1-D index of the square the new end should be a move from, or noIndex
+for any square off the path.
+
+\param wander
+If, failing that, the path is rotated on a random move anyway, so the next
+try starts from another end.
+
+\return
+If the path was rotated.
+
+*/
+/******************************************************************************/
+bool GameBoard::rotatePath( RepairPath& path, const unsigned& target, const bool& wander )
+{
+	const unsigned last = path.squares.back();
+	const unsigned length = static_cast<unsigned>(path.squares.size());
+	unsigned best = noIndex;
+
+	unsigned pivots[numMoves];
+	unsigned count = 0;
+
+	for( unsigned i=neighborStart_[last]; i<neighborStart_[last+1]; i++ )
+	{
+		//the square before the end gives the same path back.
+		const unsigned pivot = placeOnPath( path, neighbors_[i] );
+		if( pivot >= heldOff || pivot + 2 >= length || pivot + 1 < path.floor )
+			continue;
+
+		pivots[count++] = pivot;
+		if( canGoOn( path, path.squares[pivot+1], target ) && ( best == noIndex || pivot > best ) )
+			best = pivot;
+	}
+
+	if( best != noIndex )
+	{
+		reverseAfter( path, best );
+		return true;
+	}
+
+	if( searchRotations( path, target ) )
+		return true;
+
+	if( !wander || !count )
+		return false;
+
+	reverseAfter( path, pivots[ nextRandom() % count ] );
+	return true;
+}
+
+/******************************************************************************/
+/*!
+
+Cuts the path back to a square a move from index, so that it can go on to
+index next. The squares cut off are left off the path as one stretch, in
+the order they were on it. The square is drawn at random.
+
+\param path
+The path being repaired.
+
+\param index
+The 1-D index of a square off the path.
+
+*/
+/******************************************************************************/
+void GameBoard::ejectPath( RepairPath& path, const unsigned& index )
+{
+	const unsigned length = static_cast<unsigned>(path.squares.size());
+
+	unsigned cuts[numMoves];
+	unsigned count = 0;
+
+	for( unsigned i=neighborStart_[index]; i<neighborStart_[index+1]; i++ )
+	{
+		const unsigned cut = placeOnPath( path, neighbors_[i] );
+		if( cut < heldOff && cut + 1 < length && cut + 1 >= path.floor )
+			cuts[count++] = cut;
+	}
+
+	++path.work;
+	if( !count )
+		return;
+
+	const unsigned cut = cuts[ nextRandom() % count ];
+
+	for( unsigned i=cut+1; i<length; i++ )
+	{
+		const unsigned square = path.squares[i];
+
+		//the squares it was beside in the old tour no longer lead to it.
+		for( unsigned side=0; side<2; side++ )
+		{
+			const unsigned other = path.links[ 2 * square + side ];
+			if( other == noIndex )
+				continue;
+			if( path.links[ 2 * other ] == square )
+				path.links[ 2 * other ] = noIndex;
+			if( path.links[ 2 * other + 1 ] == square )
+				path.links[ 2 * other + 1 ] = noIndex;
+		}
+	}
+
+	for( unsigned i=cut+1; i<length; i++ )
+	{
+		const unsigned square = path.squares[i];
+		path.position[square] = offPath;
+		path.links[ 2 * square ] = i > cut + 1 ? path.squares[i-1] : noIndex;
+		path.links[ 2 * square + 1 ] = i + 1 < length ? path.squares[i+1] : noIndex;
+		if( !path.listed[square] )
+		{
+			path.loose.push_back( square );
+			path.listed[square] = 1;
+		}
+	}
+
+	path.squares.resize( cut + 1 );
+	path.work += length - cut - 1;
+
+	if( path.position[index] == offPath )
+	{
+		path.position[index] = static_cast<unsigned>(path.squares.size());
+		path.squares.push_back( index );
+		++path.work;
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Looks for rotations in a row that leave an end that can go on. The ends
+that rotations reach are looked at fewest rotations first, each square
+only once (Posa's set of ends). The rotations are only worked out, by where
+they move each place on the path, and just the ones found are made.
+
+\param path
+The path being repaired.
+
+\param target
+The 1-D index of the square the new end should be a move from, or noIndex
+for any square off the path.
+
+\return
+If the rotations were found, and made.
+
+*/
+/******************************************************************************/
+bool GameBoard::searchRotations( RepairPath& path, const unsigned& target )
+{
+	const unsigned length = static_cast<unsigned>(path.squares.size());
+	const unsigned stamp = ++path.stamp;
+
+	std::vector<RepairTurn>& turns = path.turns;
+	turns.clear();
+
+	RepairTurn root = { noIndex, noIndex, 0 };
+	turns.push_back( root );
+	path.mark[ path.squares.back() ] = stamp;
+
+	unsigned pivots[repairDepth];
+
+	for( unsigned node=0; node<turns.size(); node++ )
+	{
+		//the rotations that lead to this end, first to last.
+		const unsigned made = turns[node].depth;
+		for( unsigned at=node, i=made; i>0; at=turns[at].parent )
+			pivots[--i] = turns[at].pivot;
+
+		const unsigned last = path.squares[ turnPlace( pivots, made, length, length - 1, false ) ];
+
+		for( unsigned i=neighborStart_[last]; i<neighborStart_[last+1]; i++ )
+		{
+			const unsigned place = placeOnPath( path, neighbors_[i] );
+			if( place >= heldOff )
+				continue;
+
+			const unsigned pivot = turnPlace( pivots, made, length, place, true );
+			if( pivot + 2 >= length || pivot + 1 < path.floor )
+				continue;
+
+			const unsigned next = path.squares[ turnPlace( pivots, made, length, pivot + 1, false ) ];
+			if( path.mark[next] == stamp )
+				continue;
+
+			++path.work;
+			path.mark[next] = stamp;
+
+			if( canGoOn( path, next, target ) )
+			{
+				for( unsigned j=0; j<made; j++ )
+					reverseAfter( path, pivots[j] );
+				reverseAfter( path, pivot );
+				return true;
+			}
+
+			if( made + 1 < repairDepth && turns.size() < repairReach )
+			{
+				RepairTurn turn = { node, pivot, made + 1 };
+				turns.push_back( turn );
+			}
+		}
+	}
+
+	return false;
+}
+
+/******************************************************************************/
+/*!
+
+Finds where a place on the path goes after some rotations, or came from.
+
+\param pivots
+The pivots of the rotations, in the order they are made.
+
+\param count
+How many rotations there are.
+
+\param length
+The length of the path.
+
+\param place
+The place on the path.
+
+\param forward
+If place is before the rotations, rather than after.
+
+\return
+The place it goes to, or came from.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::turnPlace( const unsigned* pivots, const unsigned& count, const unsigned& length, unsigned place, const bool& forward ) const
+{
+	for( unsigned i=0; i<count; i++ )
+	{
+		const unsigned pivot = pivots[ forward ? i : count - 1 - i ];
+		if( place > pivot )
+			place = length + pivot - place;
+	}
+
+	return place;
+}
+
+/******************************************************************************/
+/*!
+
+Reverses the squares of the path after pivot.
+
+\param path
+The path being repaired.
+
+\param pivot
+The place on the path of the square the rest is turned around on.
+
+*/
+/******************************************************************************/
+void GameBoard::reverseAfter( RepairPath& path, const unsigned& pivot )
+{
+	const unsigned length = static_cast<unsigned>(path.squares.size());
+
+	std::reverse( path.squares.begin() + pivot + 1, path.squares.end() );
+	for( unsigned i=pivot+1; i<length; i++ )
+		path.position[ path.squares[i] ] = i;
+
+	path.work += length - pivot - 1;
+}
+
+/******************************************************************************/
+/*!
+
+Checks if the path could go on from a square at its end.
+
+\param path
+The path being repaired.
+
+\param index
+The 1-D index of the square.
+
+\param target
+The 1-D index of the square it should be a move from, or noIndex for any
+square off the path.
+
+\return
+If the path can go on from it.
+
+*/
+/******************************************************************************/
+bool GameBoard::canGoOn( const RepairPath& path, const unsigned& index, const unsigned& target ) const
+{
+	return target == noIndex ? countOffPath( path, index ) != 0 : isLeap( index, target );
+}
+
+/******************************************************************************/
+/*!
+
+Finds where a square is on the path. The squares of the old tour held back
+keep their places in it, which aren't places on the path: a place past the
+path's floor only counts when the path has that square there.
+
+\param path
+The path being repaired.
+
+\param index
+The 1-D index of the square.
+
+\return
+The square's place on the path, offPath if it is still to be placed, or
+heldOff if it is held back.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::placeOnPath( const RepairPath& path, const unsigned& index ) const
+{
+	const unsigned at = path.position[index];
+	if( at < path.floor || at == offPath )
+		return at;
+
+	return at < path.squares.size() && path.squares[at] == index ? at : heldOff;
+}
+
+/******************************************************************************/
+/*!
+
+Counts the squares off the path a move from a square.
+
+\param path
+The path being repaired.
+
+\param index
+The 1-D index of the square.
+
+\return
+The squares off the path it can move to.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::countOffPath( const RepairPath& path, const unsigned& index ) const
+{
+	unsigned count = 0;
+
+	for( unsigned i=neighborStart_[index]; i<neighborStart_[index+1]; i++ )
+	{
+		if( path.position[ neighbors_[i] ] == offPath )
+			++count;
+	}
+
+	return count;
+}
+
+/******************************************************************************/
+/*!
+
+Checks for a move between two open squares, by the rows and columns
+between them.
+
+\param from
+The 1-D index of one square.
+
+\param to
+The 1-D index of the other.
+
+\return
+If the piece can move from one to the other.
+
+*/
+/******************************************************************************/
+bool GameBoard::isLeap( const unsigned& from, const unsigned& to ) const
+{
+	return isLeap( get2DSpace( from ), get2DSpace( to ) );
+}
+
+/******************************************************************************/
+/*!
+
+Checks for a move between two squares already found on the board.
+
+\param a
+The row and column of one square.
+
+\param b
+The row and column of the other.
+
+\return
+If the two squares are a move apart.
+
+*/
+/******************************************************************************/
+bool GameBoard::isLeap( const Space& a, const Space& b ) const
+{
+	const unsigned rows = a.getRow() > b.getRow() ? a.getRow() - b.getRow() : b.getRow() - a.getRow();
+	const unsigned columns = a.getColumn() > b.getColumn() ? a.getColumn() - b.getColumn() : b.getColumn() - a.getColumn();
+
+	return ( rows == shortLeap_ && columns == longLeap_ ) || ( rows == longLeap_ && columns == shortLeap_ );
+}
+
+/******************************************************************************/
+/*!
+
+Finishes the tour from index through the squares left, which are few enough
+to search all at once. The region left is the free list setMove keeps, put
+in order, so finding it costs the region and not the board. It is searched
+as a set of bits, with every dead end remembered by the squares it had
+left, so no part of the region is searched twice. A region whose starts
+have all failed before is looked up instead of searched.
+
+\param index
+The 1-D index of the square just placed.
+
+\return
+If the tour was finished or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::finishEndgame( const unsigned& index )
+{
+	if( endgamePosition_.size() != size_ )
+	{
+		endgamePosition_.assign( size_, noIndex );
+		endgameMemo_.resize( maxEndgameMemo );
+	}
+
+	//the squares left, in order, and where they are in the region.
+	unsigned region[maxEndgame];
+	const unsigned count = freeCount_;
+	std::copy( freeSquares_.begin(), freeSquares_.begin() + count, region );
+	std::sort( region, region + count );
+
+	unsigned long long hash = mixSeed( endIndex_ );
+	for( unsigned a=0; a<count; a++ )
+	{
+		endgamePosition_[ region[a] ] = a;
+		hash = mixSeed( hash ^ region[a] );
+	}
+
+	//the moves from index into the region.
+	unsigned starts = 0;
+	for( unsigned i=neighborStart_[index]; i<neighborStart_[index+1]; i++ )
+	{
+		if( isAvailable(neighbors_[i]) )
+			starts |= 1u << endgamePosition_[ neighbors_[i] ];
+	}
+
+	//the starts that failed the last time the search left these squares.
+	EndgameEntry& entry = endgameMemo_[ hash & ( maxEndgameMemo - 1 ) ];
+	if( entry.count != count || entry.end != endIndex_ ||
+		!std::equal( region, region + count, entry.squares ) )
+	{
+		entry.count = count;
+		entry.end = endIndex_;
+		entry.failed = 0;
+		std::copy( region, region + count, entry.squares );
+	}
+
+	bool finished = false;
+	unsigned path[maxEndgame];
+
+	if( starts & ~entry.failed )
+	{
+		//the moves between the squares, as bits of the region.
+		unsigned adjacent[maxEndgame];
+		unsigned ends = 0;
+		for( unsigned a=0; a<count; a++ )
+		{
+			adjacent[a] = 0;
+			for( unsigned i=neighborStart_[region[a]]; i<neighborStart_[region[a]+1]; i++ )
+			{
+				if( isAvailable(neighbors_[i]) )
+					adjacent[a] |= 1u << endgamePosition_[ neighbors_[i] ];
+			}
+
+			if( endIndex_ == noIndex || endIndex_ == region[a] )
+				ends |= 1u << a;
+		}
+
+		if( endgameTable_.size() < ( 1u << count ) )
+			endgameTable_.resize( 1u << count, 0 );
+
+		const unsigned all = ( 1u << count ) - 1;
+		for( unsigned a=0; a<count && !finished; a++ )
+		{
+			const unsigned bit = 1u << a;
+			if( !( starts & bit ) || ( entry.failed & bit ) )
+				continue;
+
+			path[0] = a;
+			finished = searchEndgame( adjacent, a, all & ~bit, ends, path + 1 );
+			if( !finished )
+				entry.failed |= bit;
+		}
+
+		//the dead ends only hold for this region.
+		for( unsigned i=0; i<endgameTouched_.size(); i++ )
+			endgameTable_[ endgameTouched_[i] ] = 0;
+		endgameTouched_.clear();
+	}
+
+	for( unsigned a=0; a<count; a++ )
+		endgamePosition_[ region[a] ] = noIndex;
+
+	if( !finished )
+	{
+		message_ = MSG_FINISHED_FAIL;
+		return false;
+	}
+
+	//places the path.
+	unsigned from = index;
+	for( unsigned i=0; i<count; i++ )
+	{
+		const unsigned next = region[ path[i] ];
+
+		++iteration_;
+		currentSpace = get2DSpace( next );
+
+		if( callback_ )
+		{
+			const Space space = get2DSpace( from );
+			callback_( *this, &boardView_[0], message_, totalMoves_, rows_, columns_, space.getRow(), space.getColumn() );
+		}
+
+		message_ = MSG_PLACING;
+		++totalMoves_;
+		setMove( next, iteration_ );
+		from = next;
+	}
+
+	message_ = MSG_FINISHED_OK;
+	return true;
+}
+
+/******************************************************************************/
+/*!
+
+Looks for a path from a square of the region through the rest of it. Moves
+are tried fewest onward moves first, as Warnsdorff's rule would, and a move
+that would cut a square off from the rest is never tried. A square that
+fails with some squares left is marked in endgameTable_ for those squares.
+
+\param adjacent
+The moves out of each square of the region, as bits of the region.
+
+\param position
+The square of the region the path is on.
+
+\param left
+The squares the path still has to visit, as bits of the region.
+
+\param ends
+The squares the path may end on, as bits of the region.
+
+\param path
+Receives the squares of the path after position.
+
+\return
+If a path was found or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::searchEndgame( const unsigned* adjacent, const unsigned& position, const unsigned& left,
+                               const unsigned& ends, unsigned* path )
+{
+	if( !left )
+		return ( ends >> position ) & 1;
+
+	if( ( endgameTable_[left] >> position ) & 1 )
+		return false;
+
+	//the moves, with the number of onward moves each has.
+	unsigned moves[numMoves];
+	unsigned degrees[numMoves];
+	unsigned count = 0;
+	bool dead = false;
+
+	for( unsigned a=0; left >> a; a++ )
+	{
+		if( !( ( adjacent[position] & left ) >> a & 1 ) )
+			continue;
+
+		const unsigned rest = left & ~( 1u << a );
+		unsigned degree = 0;
+		for( unsigned onward = adjacent[a] & rest; onward; onward &= onward - 1 )
+			++degree;
+
+		//a neighbor with no way on can't be reached later, and can only be
+		//moved to now if it is the last square.
+		if( !degree && rest )
+		{
+			dead = true;
+			break;
+		}
+
+		unsigned i = count++;
+		while( i && degrees[i-1] > degree )
+		{
+			moves[i] = moves[i-1];
+			degrees[i] = degrees[i-1];
+			--i;
+		}
+		moves[i] = a;
+		degrees[i] = degree;
+	}
+
+	for( unsigned i=0; i<count && !dead; i++ )
+	{
+		path[0] = moves[i];
+		if( searchEndgame( adjacent, moves[i], left & ~( 1u << moves[i] ), ends, path + 1 ) )
+			return true;
+	}
+
+	if( !endgameTable_[left] )
+		endgameTouched_.push_back( left );
+	endgameTable_[left] |= 1u << position;
+
+	return false;
+}
+
+/******************************************************************************/
+/*!
+
+Starts a search from row,column that nextStep carries on one square at a
+time, in the same order as KnightsTour. Restarts, checkpoints and the
+endgame are left out, and the callback isn't called.
+
+\param row
+The row coordinate of the space given.
+
+\param column
+The column coordinate of the space given.
+
+\param policy
+A type of search to perform.
+
+\return
+ssPLACED once the first square is down, ssTOUR if that was the only one,
+or ssDONE if no tour can start there.
+
+*/
+/******************************************************************************/
+GameBoard::SearchStep GameBoard::beginSteps( const unsigned& row, const unsigned& column, TourPolicy policy )
+{
+	totalMoves_ = 0;
+	policy_ = policy;
+	aborted_ = false;
+	moveBudget_ = ~0u;
+	randomized_ = false;
+	nextCheckpoint_ = ~0u;
+
+	if( !isTourPossible( row, column, true ) )
+	{
+		frames_.clear();
+		rejectTour( row, column );
+		return ssDONE;
+	}
+
+	resetTour();
+	stepped_ = true;
+	currentSpace( row, column );
+
+	return placeStep( get1DIndex( row, column ) );
+}
+
+/******************************************************************************/
+/*!
+
+Carries the search on by one square: the top frame's next move is placed,
+or, once the frame has none left, the move that led to it is taken back.
+KnightsTour runs it until it finds a tour. A stepped search takes a tour
+back a square at a time like any other dead end, so it goes on to the next
+tour.
+
+\return
+What the step did. ssDONE once every move from the start has been tried,
+or once the search is stopped.
+
+*/
+/******************************************************************************/
+GameBoard::SearchStep GameBoard::nextStep( void )
+{
+	if( frames_.empty() )
+		return ssDONE;
+
+	//the last square of a tour has no frame, so its move is taken back here.
+	if( stepTour_ )
+	{
+		stepTour_ = false;
+		removeStep();
+		return ssREMOVED;
+	}
+
+	Frame& frame = frames_.back();
+
+	//The queue is empty and the board is not solved. This is a dead end,
+	//and its square is taken back by the frame below.
+	if( !frame.moveCount )
+	{
+		message_ = MSG_FINISHED_FAIL;
+		frames_.pop_back();
+		if( frames_.empty() )
+			return ssDONE;
+
+		removeStep();
+		return ssREMOVED;
+	}
+
+	//take the top.
+	const unsigned nextIndex = frame.moves[0];
+
+	if( !stepped_ )
+	{
+		//stop descending if the callback asked us to. The search is
+		//snapshotted before anything is unwound.
+		if( isAborted() )
+		{
+			if( !checkpoint_.empty() && !randomized_ )
+				writeCheckpoint();
+
+			unwindSteps();
+			message_ = MSG_FINISHED_FAIL;
+			return ssDONE;
+		}
+
+		//snapshots a long search every so often.
+		if( totalMoves_ >= nextCheckpoint_ && !randomized_ )
+		{
+			writeCheckpoint();
+			nextCheckpoint_ = totalMoves_ < ~0u - checkpointMoves_ ? totalMoves_ + checkpointMoves_ : ~0u;
+		}
+	}
+
+	//increment current move
+	++iteration_;
+
+	currentSpace = get2DSpace( nextIndex );
+
+	//call the callback function, from the square being moved from.
+	if( callback_ && !stepped_ )
+	{
+		const Space space = get2DSpace( frame.index );
+		callback_( *this, &boardView_[0], message_, totalMoves_, rows_, columns_, space.getRow(), space.getColumn() );
+	}
+
+	message_ = MSG_PLACING;
+
+	//a forced square we don't move to now can only be reached at the end.
+	for( unsigned i=0; i<frame.forcedCount; i++ )
+	{
+		if( frame.forced[i] != nextIndex )
+			endIndex_ = frame.forced[i];
+	}
+
+	return placeStep( nextIndex );
+}
+
+/******************************************************************************/
+/*!
+
+Steps the search until it finds a tour or has nothing left to try.
+
+\param step
+What the step before did.
+
+\return
+If a tour was found or not.
+
+*/
+/******************************************************************************/
+bool GameBoard::runSteps( SearchStep step )
+{
+	while( step == ssPLACED || step == ssREMOVED )
+		step = nextStep();
+
+	return step == ssTOUR;
+}
+
+/******************************************************************************/
+/*!
+
+Places a square, and gives it a frame of moves to try unless it finished a
+tour. Outside a stepped search, a region left small enough is finished
+exactly instead, and the square is taken back if that fails.
+
+\param index
+The 1-D index of the square to place.
+
+\return
+ssTOUR if every square has been reached, ssREMOVED if the endgame failed,
+ssDONE if it failed from the first square, and ssPLACED otherwise.
+
+*/
+/******************************************************************************/
+GameBoard::SearchStep GameBoard::placeStep( const unsigned& index )
+{
+	//increases the move counter.
+	++totalMoves_;
+
+	//Set the piece on the movement board.
+	setMove( index, iteration_ );
+
+	//have all the spots on the board been reached?
+	if( isSolved() )
+	{
+		//set the callback message.
+		message_ = MSG_FINISHED_OK;
+		stepTour_ = true;
+		return ssTOUR;
+	}
+
+	//a small enough region left is finished exactly.
+	if( !stepped_ && squares_ - iteration_ <= endgameSquares_ )
+	{
+		if( finishEndgame( index ) )
+			return ssTOUR;
+		if( frames_.empty() )
+			return ssDONE;
+
+		removeStep();
+		return ssREMOVED;
+	}
+
+	//get the next available moves.
+	frames_.emplace_back();
+	Frame& frame = frames_.back();
+	frame.index = index;
+	getNextAvailable( frame );
+
+	//the end square before any of the moves from here.
+	frame.previousEnd = endIndex_;
+
+	return ssPLACED;
+}
+
+/******************************************************************************/
+/*!
+
+Takes back the move the top frame is trying, once it has turned out to be a
+dead end.
+
+*/
+/******************************************************************************/
+void GameBoard::removeStep( void )
+{
+	Frame& frame = frames_.back();
+	const unsigned nextIndex = frame.moves[0];
+
+	//remove the move off the movement board.
+	setMove( nextIndex, 0 );
+
+	//pop the last space off the stack
+	popMove( frame );
+
+	//decrement current move
+	--iteration_;
+
+	message_ = MSG_REMOVING;
+
+	//no longer forced by that move.
+	endIndex_ = frame.previousEnd;
+
+	//reset the wrong space's heuristic. 
+	++cells_[nextIndex].degree;
+
+	//a stepped search tells which square was taken back.
+	if( stepped_ )
+		currentSpace = get2DSpace( nextIndex );
+}
+
+/******************************************************************************/
+/*!
+
+Takes back every square but the first once the search has been stopped,
+leaving the board as it was before the search went past it. The frames'
+queues are dropped without being popped.
+
+*/
+/******************************************************************************/
+void GameBoard::unwindSteps( void )
+{
+	//the top frame hasn't placed a move yet.
+	frames_.pop_back();
+
+	for( ; !frames_.empty(); frames_.pop_back() )
+	{
+		const Frame& frame = frames_.back();
+		const unsigned square = frame.moves[0];
+
+		setMove( square, 0 );
+		--iteration_;
+		endIndex_ = frame.previousEnd;
+		++cells_[square].degree;
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Takes the move on top of a frame's queue off it.
+
+\param frame
+The frame.
+
+*/
+/******************************************************************************/
+void GameBoard::popMove( Frame& frame ) const
+{
+	std::pop_heap( frame.moves, frame.moves + frame.moveCount, Search( this ) );
+	--frame.moveCount;
+}
+
+/******************************************************************************/
+/*!
+
+Writes the search to checkpoint_. The file is a run of native unsigned
+values: a header with the board, its layout, the counters and the hash of
+its mask, then each frame's square, end square, forced squares and heap of
+moves left, then the heuristics board. The move board is left out, since
+the frames' squares are the tour so far. The file is written beside
+checkpoint_ and renamed over it, so a process killed while writing keeps
+the last snapshot.
+
+\return
+If the snapshot was written.
+
+*/
+/******************************************************************************/
+bool GameBoard::writeCheckpoint( void ) const
+{
+	const std::string temporary = checkpoint_ + ".tmp";
+	FILE* file = fopen( temporary.c_str(), "wb" );
+	if( !file )
+		return false;
+
+	std::vector<int> heuristicsBoard( size_ );
+	for( unsigned i=0; i<size_; i++ )
+		heuristicsBoard[i] = cells_[i].degree;
+
+	const unsigned long long maskHash = GetMaskHash();
+	const unsigned header[] = { checkpointMagic, checkpointVersion, rows_, columns_, shortLeap_, longLeap_,
+	                            squares_, policy_, totalMoves_, static_cast<unsigned>(iteration_), endIndex_,
+	                            message_, currentSpace.getRow(), currentSpace.getColumn(),
+	                            static_cast<unsigned>(frames_.size()), layout_,
+	                            static_cast<unsigned>( maskHash ), static_cast<unsigned>( maskHash >> 32 ) };
+	bool written = fwrite( header, sizeof(header), 1, file ) == 1;
+
+	for( unsigned i=0; i<frames_.size() && written; i++ )
+	{
+		const Frame& frame = frames_[i];
+
+		const unsigned state[] = { frame.index, frame.previousEnd, frame.forcedCount,
+		                           frame.forced[0], frame.forced[1], frame.moveCount };
+		written = fwrite( state, sizeof(state), 1, file ) == 1 &&
+		          fwrite( frame.moves, sizeof(unsigned), frame.moveCount, file ) == frame.moveCount;
+	}
+
+	written = written &&
+	          fwrite( &heuristicsBoard[0], sizeof(int), size_, file ) == size_;
+
+	if( fclose( file ) != 0 || !written )
+		return false;
+
+	return rename( temporary.c_str(), checkpoint_.c_str() ) == 0;
+}
+
+/******************************************************************************/
+/*!
+
+Reads a snapshot written by writeCheckpoint, and puts the boards and
+counters back the way they were. Nothing is changed if the snapshot is
+damaged or was taken on another board, blocked squares included.
+
+\param path
+The snapshot to read.
+
+\param frames
+Receives the frames of the search, first move first.
+
+\return
+If the snapshot was read.
+
+*/
+/******************************************************************************/
+bool GameBoard::readCheckpoint( const char* path, std::vector<Frame>& frames )
+{
+	FILE* file = fopen( path, "rb" );
+	if( !file )
+		return false;
+
+	const unsigned long long maskHash = GetMaskHash();
+	unsigned header[18];
+	bool read = fread( header, sizeof(header), 1, file ) == 1 &&
+	            header[0] == checkpointMagic && header[1] == checkpointVersion &&
+	            header[2] == rows_ && header[3] == columns_ && header[4] == shortLeap_ &&
+	            header[5] == longLeap_ && header[6] == squares_ && header[7] <= tpLOOKAHEAD &&
+	            header[9] == header[14] && header[14] >= 1 && header[14] < squares_ &&
+	            header[11] <= MSG_REMOVING && header[12] < rows_ && header[13] < columns_ &&
+	            header[15] == static_cast<unsigned>(layout_) &&
+	            header[16] == static_cast<unsigned>( maskHash ) && header[17] == static_cast<unsigned>( maskHash >> 32 );
+
+	//the tour so far, and the moves each square has left.
+	std::vector<int> moveBoard( size_, 0 );
+	for( unsigned i=0; i<size_; i++ )
+		moveBoard[i] = masked_ && blocked_[i] ? -1 : 0;
+
+	frames.clear();
+	if( read )
+		frames.reserve( header[14] );
+
+	for( unsigned i=0; read && i<header[14]; i++ )
+	{
+		unsigned state[6];
+		read = fread( state, sizeof(state), 1, file ) == 1 &&
+		       state[0] < size_ && moveBoard[ state[0] ] == 0 &&
+		       state[2] <= 2 && state[5] >= 1 && state[5] <= numMoves;
+		if( !read )
+			break;
+
+		frames.emplace_back();
+		Frame& frame = frames.back();
+		frame.index = state[0];
+		frame.previousEnd = state[1];
+		frame.forcedCount = state[2];
+		frame.forced[0] = state[3];
+		frame.forced[1] = state[4];
+		moveBoard[ frame.index ] = static_cast<int>(i) + 1;
+
+		//the queue is read back as it was stored, since rebuilding it could
+		//change which of two tied moves comes out first.
+		frame.moveCount = state[5];
+		read = fread( frame.moves, sizeof(unsigned), frame.moveCount, file ) == frame.moveCount;
+		for( unsigned j=0; j<frame.moveCount && read; j++ )
+			read = frame.moves[j] < size_;
+
+		//each square above the last is searching its top move.
+		if( read && i )
+			read = frames[i-1].moves[0] == frame.index;
+	}
+
+	std::vector<int> heuristicsBoard( size_ );
+	read = read && fread( &heuristicsBoard[0], sizeof(int), size_, file ) == size_;
+
+	//every degree has to fit its cell.
+	for( unsigned i=0; i<size_ && read; i++ )
+		read = heuristicsBoard[i] >= 0 && heuristicsBoard[i] <= static_cast<int>(numMoves);
+
+	fclose( file );
+	if( !read )
+		return false;
+
+	policy_ = static_cast<TourPolicy>( header[7] );
+	totalMoves_ = header[8];
+	iteration_ = static_cast<int>( header[9] );
+	endIndex_ = header[10];
+	message_ = static_cast<BoardMessage>( header[11] );
+	currentSpace( header[12], header[13] );
+	for( unsigned i=0; i<size_; i++ )
+	{
+		cells_[i].move = moveBoard[i];
+		cells_[i].degree = heuristicsBoard[i];
+	}
+	boardCurrent_ = false;
+	GetBoard();
+	setFreeSquares();
+
+	return true;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the number of moves performed
+
+\return
+The number of total moves performed.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::GetMoves(void) const        // the number of moves made
+{
+	return totalMoves_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the number of squares that can be used, which is the length of a
+tour.
+
+\return
+The number of squares not blocked.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::GetSquares(void) const
+{
+	return squares_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the number of rows in the board.
+
+\return
+The number of rows.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::GetRows(void) const
+{
+	return rows_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the number of columns in the board.
+
+\return
+The number of columns.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::GetColumns(void) const
+{
+	return columns_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the short side of the piece's leap, 1 for a knight.
+
+\return
+The short side of the leap.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::GetShortLeap(void) const
+{
+	return shortLeap_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the long side of the piece's leap, 2 for a knight.
+
+\return
+The long side of the leap.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::GetLongLeap(void) const
+{
+	return longLeap_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns if a square was blocked by the mask.
+
+\param row
+The row coordinate of the square.
+
+\param column
+The column coordinate of the square.
+
+\return
+If the square is blocked.
+
+*/
+/******************************************************************************/
+bool GameBoard::IsBlocked(unsigned row, unsigned column) const
+{
+	return blocked_[ get1DIndex( row, column ) ];
+}
+
+/******************************************************************************/
+/*!
+
+Hashes the squares blocked by the mask, row by row, so a snapshot made on
+one board isn't picked up by a board blocked differently. The hash doesn't
+depend on the layout.
+
+\return
+The hash of the blocked squares.
+
+*/
+/******************************************************************************/
+unsigned long long GameBoard::GetMaskHash(void) const
+{
+	unsigned long long hash = mixSeed( 0 );
+	for( unsigned i=0; i<rows_ && masked_; i++ )
+	{
+		for( unsigned j=0; j<columns_; j++ )
+		{
+			if( blocked_[ get1DIndex( i, j ) ] )
+				hash = mixSeed( hash ^ ( i * columns_ + j ) );
+		}
+	}
+
+	return hash;
+}
+
+/******************************************************************************/
+/*!
+
+Returns where each square's moves start in the neighbor list. There is one
+more entry than there are squares, so square i's moves end where square
+i+1's start.
+
+\return
+The neighbor list offsets.
+
+*/
+/******************************************************************************/
+unsigned const *GameBoard::GetNeighborStarts(void) const
+{
+	return &neighborStart_[0];
+}
+
+/******************************************************************************/
+/*!
+
+Returns the neighbor list: the 1-D index of every move out of every square.
+
+\return
+The neighbor list.
+
+*/
+/******************************************************************************/
+unsigned const *GameBoard::GetNeighbors(void) const
+{
+	return neighbors_.empty() ? 0 : &neighbors_[0];
+}
+
+/******************************************************************************/
+/*!
+
+Returns the seed of the last restarted tour. When seeds were raced, this is
+the seed of the board that found the tour.
+
+\return
+The seed.
+
+*/
+/******************************************************************************/
+unsigned long long GameBoard::GetSeed(void) const
+{
+	return seed_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the TourPolicy member
+
+\return
+The type of search being used.
+
+*/
+/******************************************************************************/
+GameBoard::TourPolicy GameBoard::GetTourPolicy(void) const // the policy used to search
+{
+	return policy_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the Movement board, row by row. The board is only converted from
+its layout again when a move has changed since the last call, so asking for
+it over and over costs nothing more.
+
+\return
+The movement board.
+
+*/
+/******************************************************************************/
+int const *GameBoard::GetBoard(void) const
+{
+	if( !boardCurrent_ )
+	{
+		boardView_.resize( size_ );
+		for( unsigned i=0; i<size_; i++ )
+			boardView_[ getRowIndex( i ) ] = cells_[i].move;
+		boardCurrent_ = true;
+	}
+
+	return boardView_.data();
+}
+
+/******************************************************************************/
+/*!
+
+Returns how the squares are stored
+
+\return
+The board's layout.
+
+*/
+/******************************************************************************/
+GameBoard::BoardLayout GameBoard::GetLayout(void) const
+{
+	return layout_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns if the tables are on huge pages
+
+\return
+If the board was built with huge pages.
+
+*/
+/******************************************************************************/
+bool GameBoard::IsHugePaged(void) const
+{
+	return cells_.get_allocator().IsHuge();
+}
+
+/******************************************************************************/
+/*!
+
+Returns the heuristics board
+
+\return
+The heuristics board.
+
+*/
+/******************************************************************************/
+int const *GameBoard::GetHTable(void) const
+{
+	heuristicsView_.resize( size_ );
+	for( unsigned i=0; i<size_; i++ )
+		heuristicsView_[ getRowIndex( i ) ] = cells_[i].degree;
+
+	return heuristicsView_.data();
+}
+
+/******************************************************************************/
+/*!
+
+Returns the distance board. The search only keeps how the distances rank,
+so they are worked out again here.
+
+\return
+The distance board.
+
+*/
+/******************************************************************************/
+double const *GameBoard::GetDTable(void) const // 1-D representation of distance table
+{
+	distanceView_.resize( size_ );
+
+	for( unsigned i=0; i<rows_; i++ )
+	{
+		const double y = static_cast<int>(i) - (static_cast<double>(rows_-1)/2.0);
+
+		for( unsigned j=0; j<columns_; j++ )
+		{
+			const double x = static_cast<int>(j) - (static_cast<double>(columns_-1)/2.0);
+			distanceView_[ (i*columns_)+j ] = sqrt( (x*x) + (y*y) );
+		}
+	}
+
+	return distanceView_.data();
+}
+
+
+/******************************************************************************/
+/*!
+
+Returns the lookahead board. The search works the sums out as it compares
+squares, so they are worked out again here.
+
+\return
+The lookahead board, or null until a tour has run.
+
+*/
+/******************************************************************************/
+int const *GameBoard::GetLTable(void) const
+{
+	if( !iteration_ )
+		return 0;
+
+	lookaheadView_.resize( size_ );
+	for( unsigned i=0; i<size_; i++ )
+		lookaheadView_[ getRowIndex( i ) ] = getLookahead( i );
+
+	return lookaheadView_.data();
+}
+
+/******************************************************************************/
+/*!
+
+Returns the random tie-break board
+
+\return
+The random tie-break board, or null on boards that aren't randomized.
+
+*/
+/******************************************************************************/
+unsigned const *GameBoard::GetRTable(void) const
+{
+	return getView( randomBoard_, randomView_ );
+}
+
+/******************************************************************************/
+/*!
+
+Returns if ties are being broken by the random tie-break board
+
+\return
+If the search is randomized.
+
+*/
+/******************************************************************************/
+bool GameBoard::IsRandomized(void) const
+{
+	return randomized_;
+}
+
+/******************************************************************************/
+/*!
+
+Works out where each square is stored. Tiles are stored row by row, and the
+squares of a tile row by row within it; the tiles on the right and bottom
+edges are cut short. Z-order interleaves the bits of the row and column, and
+the squares off the board are left out.
+
+*/
+/******************************************************************************/
+void GameBoard::setLayout( void )
+{
+	storageIndex_.clear();
+	rowIndex_.clear();
+
+	if( layout_ == blROWS )
+		return;
+
+	rowIndex_.reserve( size_ );
+
+	if( layout_ == blTILES )
+	{
+		for( unsigned top=0; top<rows_; top+=tileSize )
+			for( unsigned left=0; left<columns_; left+=tileSize )
+				for( unsigned i=top; i<rows_ && i<top+tileSize; i++ )
+					for( unsigned j=left; j<columns_ && j<left+tileSize; j++ )
+						rowIndex_.push_back( (i*columns_)+j );
+	}
+	else
+	{
+		//the smallest block that holds the board.
+		unsigned long long side = 1;
+		while( side < rows_ || side < columns_ )
+			side *= 2;
+
+		listMorton( rows_, columns_, 0, 0, side, rowIndex_ );
+	}
+
+	storageIndex_.resize( size_ );
+	for( unsigned i=0; i<size_; i++ )
+		storageIndex_[ rowIndex_[i] ] = i;
+}
+
+/******************************************************************************/
+/*!
+
+Sets the values in the movement board to 0, and -1 on blocked squares.
+
+*/
+/******************************************************************************/
+void GameBoard::setMoveBoard( void )
+{
+	cells_.resize( size_ );
+
+	for( unsigned i=0; i<size_; i++ )
+	{
+		cells_[i].move = masked_ && blocked_[i] ? -1 : 0;
+	}
+	boardCurrent_ = false;
+	setFreeSquares();
+
+	if( callback_ )
+		GetBoard();
+}
+
+/******************************************************************************/
+/*!
+
+Lists the free squares in front of the rest, when an endgame is set, so that
+setMove can keep the list as squares are taken and freed. Without an
+endgame there is no list, and setMove leaves it alone.
+
+*/
+/******************************************************************************/
+void GameBoard::setFreeSquares( void )
+{
+	freeCount_ = 0;
+
+	if( !endgameSquares_ )
+	{
+		freeSquares_.clear();
+		freePlace_.clear();
+		return;
+	}
+
+	freeSquares_.resize( size_ );
+	freePlace_.resize( size_ );
+
+	unsigned taken = size_;
+	for( unsigned i=0; i<size_; i++ )
+	{
+		const unsigned place = isAvailable(i) ? freeCount_++ : --taken;
+		freeSquares_[place] = i;
+		freePlace_[i] = place;
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Sets the values in the heuristics board to the number of moves out of each
+square.
+
+*/
+/******************************************************************************/
+void GameBoard::setHeuristicsBoard( void )
+{
+	for( unsigned i=0; i<size_; i++ )
+		cells_[i].degree = neighborStart_[i+1] - neighborStart_[i];
+}
+
+/******************************************************************************/
+/*!
+
+Builds the neighbor lists from the jump offsets, leaving out moves that land
+off the board or on a blocked square. Also counts the open squares of each
+colour, and lists those with one move or none. The lists are written straight into tables sized for every move;
+squares stored row by row are stepped through without dividing, and those
+far enough from the edges of an unmasked board take each move as a fixed
+offset.
+
+\param mask
+One flag per square, row by row, false where the square can't be used.
+Null uses every square.
+
+\param jumps
+The piece's displacement values.
+
+*/
+/******************************************************************************/
+template< class Jumps >
+void GameBoard::setNeighbors( bool const *mask, const Jumps& jumps )
+{
+	masked_ = false;
+	blocked_.assign( size_, false );
+
+	if( mask )
+	{
+		for( unsigned i=0; i<rows_; i++ )
+		{
+			for( unsigned j=0; j<columns_; j++ )
+			{
+				const bool blocked = !mask[ (i*columns_) + j ];
+				blocked_[ get1DIndex( i, j ) ] = blocked;
+				masked_ = masked_ || blocked;
+			}
+		}
+	}
+
+	squares_ = 0;
+	evenSquares_ = 0;
+	oddSquares_ = 0;
+	loneSquares_.clear();
+
+	//the moves out of a square in the middle of a board stored row by row.
+	int offsets[numMoves];
+	for( unsigned k=0; k<jumps.count; k++ )
+		offsets[k] = ( jumps.rJump[k] * static_cast<int>(columns_) ) + jumps.cJump[k];
+	const bool fixed = layout_ == blROWS && !masked_;
+
+	neighborStart_.resize( size_ + 1 );
+	neighbors_.resize( static_cast<size_t>(size_) * jumps.count );
+	unsigned count = 0;
+
+	//the squares are listed in the order they are stored.
+	unsigned i = 0;
+	unsigned j = 0;
+	for( unsigned index=0; index<size_; index++ )
+	{
+		if( layout_ != blROWS )
+		{
+			const Space space = get2DSpace( index );
+			i = space.getRow();
+			j = space.getColumn();
+		}
+		else if( index && ++j == columns_ )
+		{
+			j = 0;
+			++i;
+		}
+
+		neighborStart_[index] = count;
+
+		if( blocked_[index] )
+			continue;
+
+		++squares_;
+		if( (i + j) % 2 )
+			++oddSquares_;
+		else
+			++evenSquares_;
+
+		if( fixed && i >= longLeap_ && j >= longLeap_ && i + longLeap_ < rows_ && j + longLeap_ < columns_ )
+		{
+			for( unsigned k=0; k<jumps.count; k++ )
+				neighbors_[ count++ ] = index + offsets[k];
+			continue;
+		}
+
+		for( unsigned k=0; k<jumps.count; k++ )
+		{
+			const unsigned row = i + jumps.rJump[k];
+			const unsigned column = j + jumps.cJump[k];
+
+			//unsigned wrap-around takes care of the negative side.
+			if( row < rows_ && column < columns_ && !blocked_[ get1DIndex( row, column ) ] )
+				neighbors_[ count++ ] = get1DIndex( row, column );
+		}
+
+		if( count - neighborStart_[index] <= 1 )
+			loneSquares_.push_back( index );
+	}
+
+	neighborStart_[size_] = count;
+	neighbors_.resize( count );
+}
+
+/******************************************************************************/
+/*!
+
+Sets the values in the distance board based on a positions distance from
+center. Only the order of the distances matters to the search, so they are
+kept squared and doubled, as whole numbers: the sum of a term for the row
+and a term for the column, worked out once each. On boards too big for
+those to fit a cell, each square keeps the rank of its distance among all
+of them. The distances that occur are marked in a table of bits, one per
+distance (they are all alike mod 4, so a quarter of them are told apart),
+and the rank is the count of bits set before it. Boards so thin that the
+table would outgrow the board sort the distances of one quarter instead.
+
+*/
+/******************************************************************************/
+void GameBoard::setDistanceBoard( void )
+{
+	if( !size_ )
+		return;
+
+	std::vector<unsigned long long> rowTerms( rows_ );
+	for( unsigned i=0; i<rows_; i++ )
+	{
+		const long long y = (2*static_cast<long long>(i)) - (rows_-1);
+		rowTerms[i] = y*y;
+	}
+
+	std::vector<unsigned long long> columnTerms( columns_ );
+	for( unsigned j=0; j<columns_; j++ )
+	{
+		const long long x = (2*static_cast<long long>(j)) - (columns_-1);
+		columnTerms[j] = x*x;
+	}
+
+	//the corners are farthest, and every row and column term appears in the
+	//top left quarter.
+	const unsigned long long farthest = rowTerms[0] + columnTerms[0];
+	const unsigned halfRows = (rows_+1) / 2;
+	const unsigned halfColumns = (columns_+1) / 2;
+
+	if( farthest <= maxRank )
+	{
+		for( unsigned i=0; i<rows_; i++ )
+			for( unsigned j=0; j<columns_; j++ )
+				cells_[ get1DIndex( i, j ) ].rank = static_cast<unsigned>( rowTerms[i] + columnTerms[j] );
+		return;
+	}
+
+	const unsigned long long words = ( farthest >> 8 ) + 1;
+	if( words <= size_ )
+	{
+		std::vector<unsigned long long> seen( static_cast<size_t>(words), 0 );
+		for( unsigned i=0; i<halfRows; i++ )
+		{
+			for( unsigned j=0; j<halfColumns; j++ )
+			{
+				const unsigned long long key = ( rowTerms[i] + columnTerms[j] ) >> 2;
+				seen[ key >> 6 ] |= 1ULL << ( key & 63 );
+			}
+		}
+
+		//the distances before each word of bits.
+		std::vector<unsigned> before( static_cast<size_t>(words) );
+		unsigned total = 0;
+		for( size_t w=0; w<before.size(); w++ )
+		{
+			before[w] = total;
+			total += static_cast<unsigned>( std::popcount( seen[w] ) );
+		}
+
+		for( unsigned i=0; i<rows_; i++ )
+		{
+			for( unsigned j=0; j<columns_; j++ )
+			{
+				const unsigned long long key = ( rowTerms[i] + columnTerms[j] ) >> 2;
+				const unsigned rank = before[ key >> 6 ] +
+					static_cast<unsigned>( std::popcount( seen[ key >> 6 ] & ( ( 1ULL << ( key & 63 ) ) - 1 ) ) );
+				//the farthest squares of boards too big to rank tie.
+				cells_[ get1DIndex( i, j ) ].rank = rank < maxRank ? rank : maxRank;
+			}
+		}
+		return;
+	}
+
+	std::vector<unsigned long long> order;
+	order.reserve( static_cast<size_t>(halfRows) * halfColumns );
+	for( unsigned i=0; i<halfRows; i++ )
+		for( unsigned j=0; j<halfColumns; j++ )
+			order.push_back( rowTerms[i] + columnTerms[j] );
+	std::sort( order.begin(), order.end() );
+	order.erase( std::unique( order.begin(), order.end() ), order.end() );
+
+	for( unsigned i=0; i<rows_; i++ )
+	{
+		for( unsigned j=0; j<columns_; j++ )
+		{
+			const unsigned rank = static_cast<unsigned>(
+				std::lower_bound( order.begin(), order.end(), rowTerms[i] + columnTerms[j] ) - order.begin() );
+			//the farthest squares of boards too big to rank tie.
+			cells_[ get1DIndex( i, j ) ].rank = rank < maxRank ? rank : maxRank;
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Finds the next available squares, adds them if available, and sorts them based on policy.
+
+\param frame
+The square given. Receives the next moves possible as its queue, and the
+squares that have to be moved to next or ended on.
+
+*/
+/******************************************************************************/
+void GameBoard::getNextAvailable( Frame& frame )
+{
+	const unsigned& index = frame.index;
+	unsigned* const candidates = frame.moves;
+	unsigned count = 0;
+
+	const unsigned* neighbor = &neighbors_[0] + neighborStart_[index];
+	const unsigned* const last = &neighbors_[0] + neighborStart_[index+1];
+
+	for( ; neighbor != last; ++neighbor )
+	{
+		//If the square is available on the board, we keep it as a candidate.
+		if( isAvailable(*neighbor) )
 		{
 			//decrements the element in the heuristics board
-			const unsigned index = get1DIndex( space.getRow(), space.getColumn() );
-			--heuristicsBoard_[index];
+			--cells_[*neighbor].degree;
 
-			//pushes the space onto the queue.
-			nextMoves.push( space );
+			candidates[count++] = *neighbor;
 		}
 	}
 
-	return nextMoves;
+	//every policy drops the moves that strand a square. The static policy
+	//backtracks the most, so it gains the most.
+	count = PruneDeadEnds( candidates, count, squares_ - iteration_, endIndex_,
+	                       [this]( const unsigned& square ) { return static_cast<unsigned>(cells_[square].degree); },
+	                       [this]( const unsigned& square ) { ++cells_[square].degree; }, frame.forced, frame.forcedCount );
+
+	//restarted tours draw a fresh tie-break for every candidate.
+	if( randomized_ )
+	{
+		for( unsigned i=0; i<count; i++ )
+			randomBoard_[ candidates[i] ] = nextRandom();
+	}
+
+	//pushes the squares onto the queue.
+	const Search search( this );
+	for( unsigned i=1; i<count; i++ )
+		std::push_heap( candidates, candidates + i + 1, search );
+	frame.moveCount = count;
+}
+
+/******************************************************************************/
+/*!
+
+Sums the heuristic values of every available square one jump away. This is
+Pohl's tie-break, and costs at most numMoves reads per candidate.
+
+Search works this out only for the squares that tie on degree and rank, and
+each time it compares them, so the sums are never stored. A frame's queue is
+only touched once the moves below it are taken back, and the board is then
+as it was when the queue was built, but for the moves already tried. No
+leaper joins two squares a leap from the same square, so those are never
+one of the squares summed, and the sums come out the same each time.
+
+\param index
+The 1-D index of the candidate square.
+
+\return
+The second-level degree sum of the candidate.
+
+*/
+/******************************************************************************/
+int GameBoard::getLookahead( const unsigned& index ) const
+{
+	int sum = 0;
+
+	for( unsigned i=neighborStart_[index]; i<neighborStart_[index+1]; i++ )
+	{
+		if( isAvailable(neighbors_[i]) )
+			sum += cells_[ neighbors_[i] ].degree;
+	}
+
+	return sum;
 }
 
 /******************************************************************************/
@@ -571,38 +3834,137 @@ The index of the array
 /******************************************************************************/
 unsigned GameBoard::get1DIndex( const unsigned& row, const unsigned& column ) const
 {
-	return (row*columns_)+column;
+	if( layout_ == blROWS )
+		return (row*columns_)+column;
+
+	return storageIndex_[ (row*columns_)+column ];
 }
 
 /******************************************************************************/
 /*!
 
-Determines if a Space given is in bounds and has not been already used..
+Finds the 2-D coordinates of a square from its 1-D index.
 
-\param space
-The space to check
+\param index
+The 1-D index of the square given.
 
 \return
-If the space is available or not
+The space at that index.
 
 */
 /******************************************************************************/
-bool GameBoard::isAvailable( const Space& space ) const
+const Space GameBoard::get2DSpace( const unsigned& index ) const
 {
-	const unsigned row = space.getRow();
-	const unsigned column = space.getColumn();
+	const unsigned square = layout_ == blROWS ? index : rowIndex_[index];
+	return Space( square / columns_, square % columns_ );
+}
 
-	//checks if position is out of bounds.
-	if( row >= rows_ )
-		return false;
-	if( column >= columns_ )
-		return false;
+/******************************************************************************/
+/*!
+
+Determines if a square has not been already used. Squares off the board or
+blocked never show up in the neighbor lists, so they aren't checked here.
 
-	//checks if the position has already been reached.
-	const unsigned index = get1DIndex( row, column );
+\param index
+The 1-D index of the square to check
 
+\return
+If the square is available or not
+
+*/
+/******************************************************************************/
+bool GameBoard::isAvailable( const unsigned& index ) const
+{
 	//returns the opposite of the move board status at the index.
-	return moveBoard_[index] == 0;
+	return cells_[index].move == 0;
+}
+
+/******************************************************************************/
+/*!
+
+Sets the move number of a square. When the callback is handed the board row
+by row, its copy is kept up to date too.
+
+\param index
+The 1-D index of the square to set.
+
+\param move
+The move number, or 0 to take the piece off.
+
+*/
+/******************************************************************************/
+void GameBoard::setMove( const unsigned& index, const int& move )
+{
+	//a square taken or freed is swapped across the end of the free squares.
+	if( !freeSquares_.empty() && ( cells_[index].move == 0 ) != ( move == 0 ) )
+	{
+		const unsigned edge = move ? --freeCount_ : freeCount_++;
+		const unsigned other = freeSquares_[edge];
+		const unsigned place = freePlace_[index];
+
+		freeSquares_[place] = other;
+		freePlace_[other] = place;
+		freeSquares_[edge] = index;
+		freePlace_[index] = edge;
+	}
+
+	cells_[index].move = move;
+
+	if( callback_ )
+		boardView_[ getRowIndex( index ) ] = move;
+	else
+		boardCurrent_ = false;
+}
+
+/******************************************************************************/
+/*!
+
+Finds where a square is in the boards handed out row by row.
+
+\param index
+The 1-D index of the square given.
+
+\return
+The square's row-major index.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::getRowIndex( const unsigned& index ) const
+{
+	return layout_ == blROWS ? index : rowIndex_[index];
+}
+
+/******************************************************************************/
+/*!
+
+Returns a board row by row. Boards stored row by row are returned as they
+are; otherwise each square is copied to its place in view.
+
+\param board
+The board, in the board's layout.
+
+\param view
+Receives the board row by row.
+
+\return
+The board row by row, or null if it hasn't been filled in.
+
+*/
+/******************************************************************************/
+template< class T >
+const T* GameBoard::getView( const Table<T>& board, std::vector<T>& view ) const
+{
+	if( board.empty() )
+		return 0;
+
+	if( layout_ == blROWS )
+		return board.data();
+
+	view.resize( board.size() );
+	for( unsigned i=0; i<board.size(); i++ )
+		view[ rowIndex_[i] ] = board[i];
+
+	return view.data();
 }
 
 /******************************************************************************/
@@ -617,13 +3979,50 @@ If the board has been solved or not
 /******************************************************************************/
 bool GameBoard::isSolved( void ) const
 {
-	//Iterate through the spots on the board.
-	for( unsigned i=0; i< moveBoard_.size(); i++ )
-	{
-		//If not all spots have been reached, return false.
-		if( !moveBoard_[i] ) return false;
-	}
+	//Every move lands on a new spot, so the move number is the number of spots reached.
+	return static_cast<unsigned>(iteration_) == squares_;
+}
 
-	//All spots have been reached.
-	return true;
+/******************************************************************************/
+/*!
+
+Sends MSG_ABORT_CHECK to the callback. Once the callback asks to stop, the
+search unwinds without asking again.
+
+\return
+If the search should stop or not
+
+*/
+/******************************************************************************/
+bool GameBoard::isAborted( void )
+{
+	//an attempt that has used up its budget unwinds without giving up the restarts.
+	if( totalMoves_ >= moveBudget_ )
+		return true;
+
+	if( !aborted_ && stop_ && *stop_ )
+		aborted_ = true;
+
+	if( !aborted_ && callback_ )
+		aborted_ = callback_( *this, &boardView_[0], MSG_ABORT_CHECK, totalMoves_, rows_, columns_, currentSpace.getRow(), currentSpace.getColumn() );
+
+	return aborted_;
+}
+
+/******************************************************************************/
+/*!
+
+Steps the xorshift64* generator used for tie-breaking.
+
+\return
+The next 32 random bits.
+
+*/
+/******************************************************************************/
+unsigned GameBoard::nextRandom( void )
+{
+	randomState_ ^= randomState_ >> 12;
+	randomState_ ^= randomState_ << 25;
+	randomState_ ^= randomState_ >> 27;
+	return static_cast<unsigned>( (randomState_ * 0x2545F4914F6CDD1DULL) >> 32 );
 }
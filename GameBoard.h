@@ -20,7 +20,10 @@ of the classes GameBoard, Search, and Space.
 //---------------------------------------------------------------------------
 
 #include <vector>
-#include <queue>
+#include <string>
+#include <atomic>
+#include <memory>
+#include "BoardMemory.h"
 
 // Represents a space on the board.
 struct Space
@@ -40,8 +43,10 @@ public:
 	const Space& operator=( const Space& rhs );
 };
 
-// Forward declaration
+// Forward declarations
 class Search;
+class TourGenerator;
+class KnightGraph;
 
 class GameBoard
 {
@@ -68,35 +73,94 @@ class GameBoard
 
     enum TourPolicy 
     {
-      tpSTATIC,    // use a fixed set of offsets for next move
-      tpHEURISTICS // use heuristics for next move
+      tpSTATIC,     // use a fixed set of offsets for next move
+      tpHEURISTICS, // use heuristics for next move
+      tpLOOKAHEAD   // use heuristics, break ties with Pohl's second-level degree sums
+    };
+
+    enum BoardLayout
+    {
+      blROWS,   // squares stored row by row
+      blTILES,  // squares stored in 16x16 tiles, row by row within each
+      blMORTON  // squares stored in Z-order (Morton order)
     };
 
     // Constructor/Destructor
-    GameBoard(unsigned rows, unsigned columns, KNIGHTS_CALLBACK callback = 0);
+      // mask is rows*columns flags, row by row, false for squares that can't be used
+      // shortLeap,longLeap is the piece: 1,2 knight, 1,3 camel, 2,3 zebra, 1,4 giraffe
+      // layout is how squares are stored; every board handed out is still row by row
+      // hugePages puts the tables the search runs over on 2 MB pages
+    GameBoard(unsigned rows, unsigned columns, KNIGHTS_CALLBACK callback = 0, bool const *mask = 0,
+              unsigned shortLeap = 1, unsigned longLeap = 2, BoardLayout layout = blROWS,
+              bool hugePages = false);
     ~GameBoard();
 
       // Starts the tour at row,column using specified tour policy
     bool KnightsTour(unsigned row, unsigned column, TourPolicy policy = tpSTATIC);
+      // Restarts seeded tours on a Luby schedule of move budgets, racing seeds on threads
+    bool KnightsTourRestarts(unsigned row, unsigned column, TourPolicy policy,
+                             unsigned long long seed, unsigned threads = 1, unsigned attempts = 64);
+    unsigned long long GetSeed(void) const; // the seed that found the last restarted tour
+
+      // Snapshots KnightsTour searches to path every moves moves, and when aborted (0 stops)
+    void SetCheckpoint(const char *path, unsigned moves = 10000000);
+      // Carries on the search snapshotted in path exactly where it left off
+    bool KnightsTourResume(const char *path);
+
+      // Turns tour, a GetBoard() of a board this size, into a tour of this board
+      // from row,column (and ending on endRow,endColumn if given), keeping what
+      // it can of the old tour
+    bool KnightsTourRepair(int const *tour, unsigned row, unsigned column,
+                           unsigned endRow = ~0u, unsigned endColumn = ~0u);
+
+      // Finishes tours exactly once squares or fewer are left (0 is off, at most 20)
+    void SetEndgame(unsigned squares);
+
+      // False when no tour (open, or closed) can start at row,column on a rows x columns board
+    static bool IsTourPossible(unsigned rows, unsigned columns, unsigned row, unsigned column,
+                               bool closed = false);
     unsigned GetMoves(void) const;        // the number of moves made
     TourPolicy GetTourPolicy(void) const; // the policy used to search
-    int const *GetBoard(void) const;      // 1-D representation of board state
+    int const *GetBoard(void) const;      // 1-D representation of board state (-1 is blocked)
+    BoardLayout GetLayout(void) const;    // how squares are stored
+    bool IsHugePaged(void) const;         // are the tables on huge pages
+    unsigned GetSquares(void) const;      // the number of squares that can be used
+    unsigned GetRows(void) const;         // the number of rows in the board
+    unsigned GetColumns(void) const;      // the number of columns in the board
+    unsigned GetShortLeap(void) const;    // the short side of the piece's leap
+    unsigned GetLongLeap(void) const;     // the long side of the piece's leap
+    bool IsBlocked(unsigned row, unsigned column) const; // is the square masked out
+    unsigned long long GetMaskHash(void) const; // a hash of the blocked squares
 
-      // Debugging helpers
+      // The moves out of square i are GetNeighbors()[GetNeighborStarts()[i]]
+      // up to GetNeighbors()[GetNeighborStarts()[i+1]], as 1-D indices (get1DIndex)
+    unsigned const *GetNeighborStarts(void) const;
+    unsigned const *GetNeighbors(void) const;
+
+      // Debugging helpers, row by row
     int const *GetHTable(void) const;    // 1-D representation of heuristic table
     double const *GetDTable(void) const; // 1-D representation of distance table
+    int const *GetLTable(void) const;    // 1-D representation of lookahead table
+    unsigned const *GetRTable(void) const; // 1-D representation of random tie-break table
+    bool IsRandomized(void) const;       // are ties being broken by the random table
 
-	//takes the 2-D coordinates and returns a 1-D index.
+	//takes the 2-D coordinates and returns a 1-D index, in the board's layout.
 	unsigned get1DIndex( const unsigned& row, const unsigned& column ) const;
+	//takes a 1-D index and returns the 2-D coordinates.
+	const Space get2DSpace( const unsigned& index ) const;
 
   private:
+    friend class Search;
+    friend class TourGenerator;
+    friend class KnightGraph;
+
     unsigned rows_;
     unsigned columns_;
     KNIGHTS_CALLBACK callback_;
     TourPolicy policy_;
+    BoardLayout layout_;
     
     // Other private fields and methods ...
-	typedef std::priority_queue< Space, std::vector<Space>, Search > MoveContainer;
 	
 	//keeps track of the total moves
 	unsigned totalMoves_;
@@ -104,33 +168,315 @@ class GameBoard
 	int iteration_;
 	//knows the size of the arrays.
 	unsigned size_;
+	//the number of squares a tour has to cover.
+	unsigned squares_;
+	//the piece's leap.
+	unsigned shortLeap_;
+	unsigned longLeap_;
+	//is any square blocked, and which.
+	bool masked_;
+	std::vector<bool> blocked_;
+	//the squares of each colour that can be used.
+	unsigned evenSquares_;
+	unsigned oddSquares_;
 	//keeps track of the current board message.
 	BoardMessage message_;
 	//keeps track of the latest spot.
 	Space currentSpace;
 
+	//One square of the move, heuristics and distance boards, packed so a
+	//candidate is read from one cache line: its move number (0 free, -1
+	//blocked), its moves left to free squares, and a number that orders its
+	//distance from the center, nearest lowest.
+	struct Cell
+	{
+		int move;
+		unsigned degree : 8;
+		unsigned rank : 24;
+	};
+
+	//The tables the search runs over, on huge pages when asked for.
+	template< class T >
+	using Table = std::vector< T, BoardAllocator<T> >;
+
 	//The boards.
-	std::vector<int> heuristicsBoard_;
-	std::vector<double> distanceBoard_;
-	std::vector<int> moveBoard_;
+	Table<Cell> cells_;
+
+	//Where each square is stored, by row-major index, and back. Both are
+	//empty when the squares are stored row by row.
+	Table<unsigned> storageIndex_;
+	Table<unsigned> rowIndex_;
+	//The boards row by row, for the accessors. The move board's is kept up
+	//to date during the search when there is a callback to hand it to, and
+	//otherwise marked out of date until GetBoard is next called.
+	mutable std::vector<int> boardView_;
+	mutable bool boardCurrent_;
+	mutable std::vector<int> heuristicsView_;
+	mutable std::vector<double> distanceView_;
+	mutable std::vector<int> lookaheadView_;
+	mutable std::vector<unsigned> randomView_;
+
+	//The moves out of each square, in jump order. The moves from square i
+	//are neighbors_[ neighborStart_[i] ] up to neighbors_[ neighborStart_[i+1] ].
+	//Blocked squares have no moves, and are never a move.
+	Table<unsigned> neighborStart_;
+	Table<unsigned> neighbors_;
+	//The open squares with one move or none, which can only be an end.
+	std::vector<unsigned> loneSquares_;
+
+	//set when the callback asks the search to stop.
+	bool aborted_;
+	//the search gives up once totalMoves_ reaches this.
+	unsigned moveBudget_;
+	//raised by a racing board once it has found a tour.
+	const std::atomic<bool>* stop_;
+
+	//where and how often the search is snapshotted.
+	std::string checkpoint_;
+	unsigned checkpointMoves_;
+	unsigned nextCheckpoint_;
+
+	//the most moves a square has.
+	static const unsigned maxMoves = 8;
+	//the squares of the search being run, one per move, first move first.
+	//The search runs on this stack rather than the call stack, so it goes
+	//as deep as the board does, and can be snapshotted or stepped.
+	struct Frame;
+	std::vector<Frame> frames_;
+
+	//the tour is finished exactly once this few squares are left.
+	unsigned endgameSquares_;
+	//the most squares an endgame is finished over.
+	static const unsigned maxEndgame = 20;
+	//one remembered region: its squares, the end it needs, and the squares
+	//next to it that failed to start a path through it.
+	struct EndgameEntry
+	{
+		unsigned count;
+		unsigned end;
+		unsigned failed;
+		unsigned squares[maxEndgame];
+		EndgameEntry( void ) : count(0), end(~0u), failed(0) {}
+	};
+	//the starts each region has failed to be finished from, by a hash of
+	//the region's squares and required end.
+	std::vector<EndgameEntry> endgameMemo_;
+	//where each square is in the region being finished.
+	std::vector<unsigned> endgamePosition_;
+	//the squares of the region being finished that failed with each subset
+	//of it left, and the subsets marked.
+	std::vector<unsigned> endgameTable_;
+	std::vector<unsigned> endgameTouched_;
+	//the free squares, kept up to date by setMove while an endgame is set,
+	//so the region left is found without scanning the board: the first
+	//freeCount_ squares of freeSquares_ are free, and freePlace_ is where
+	//each square is in it.
+	std::vector<unsigned> freeSquares_;
+	std::vector<unsigned> freePlace_;
+	unsigned freeCount_;
+
+	//seeded tie-breaking for restarts.
+	bool randomized_;
+	unsigned long long seed_;
+	unsigned long long randomState_;
+	Table<unsigned> randomBoard_;
+
+	//resets the boards and runs one search from row,column.
+	bool startTour( const unsigned& row, const unsigned& column );
+
+	//resets the boards and counters for a new search.
+	void resetTour( void );
+
+	//What the search did in one step.
+	enum SearchStep
+	{
+	  ssPLACED,  // placed a square
+	  ssREMOVED, // took a square back off
+	  ssTOUR,    // placed the last square
+	  ssDONE     // has nothing left to try
+	};
+
+	//is the search being stepped from outside, and was its last step a tour.
+	bool stepped_;
+	bool stepTour_;
+
+	//starts a search from row,column that is run one step at a time.
+	SearchStep beginSteps( const unsigned& row, const unsigned& column, TourPolicy policy );
+
+	//carries the search on by one square. After a tour, a stepped search
+	//backs off its last square and carries on to the next tour.
+	SearchStep nextStep( void );
+
+	//steps the search until it finds a tour or has nothing left to try.
+	bool runSteps( SearchStep step );
+
+	//places a square, and gives it a frame of moves unless the tour is done.
+	SearchStep placeStep( const unsigned& index );
+
+	//takes back the move being tried by the top frame.
+	void removeStep( void );
+
+	//takes back every square but the first, once the search is stopped.
+	void unwindSteps( void );
+
+	//resets the boards for a tour that can't exist.
+	void rejectTour( const unsigned& row, const unsigned& column );
+
+	//IsTourPossible, for this board and its mask.
+	bool isTourPossible( const unsigned& row, const unsigned& column, const bool& walk ) const;
+
+	//runs budgeted, randomized attempts until one finds a tour.
+	bool restartTours( const unsigned& row, const unsigned& column, const unsigned& attempts );
+
+	//A rotation a repair has worked out: the one made before it (noIndex for
+	//none), the place on the path it turns on, and how many are made.
+	struct RepairTurn
+	{
+	  unsigned parent;
+	  unsigned pivot;
+	  unsigned depth;
+	};
+
+	//The path a repair grows: its squares in order, where each square is on
+	//it (offPath if it isn't, or for the old tour held back, its place in
+	//that), each square's moves before and after it in the old tour, the
+	//squares placed and moved so far, and room to list a stretch of the old
+	//tour and rotations in. The squares that may be off the path are listed
+	//once each. Each square keeps the last stamp that marked it: the pass of
+	//splices that tried its stretch, or the search of rotations that reached
+	//it. The path before floor is kept as it was, and the old tour from
+	//ceiling on is held back. The links, listings and stamps are only set
+	//for the squares searched again.
+	struct RepairPath
+	{
+	  std::vector<unsigned> squares;
+	  std::vector<unsigned> position;
+	  std::unique_ptr<unsigned[]> links;
+	  unsigned long long work;
+	  std::vector<unsigned> stretch;
+	  std::vector<RepairTurn> turns;
+	  std::vector<unsigned> loose;
+	  std::unique_ptr<unsigned char[]> listed;
+	  std::unique_ptr<unsigned[]> mark;
+	  unsigned stamp;
+	  unsigned floor;
+	  unsigned ceiling;
+	};
 
-	//recursive call.
-	bool PlaceKnight( const unsigned& row, const unsigned& column );
+	//can a tour from row,column end on endRow,endColumn.
+	bool isEndPossible( const unsigned& row, const unsigned& column, const unsigned& endRow, const unsigned& endColumn ) const;
+
+	//turns the old tour into a path from start through every square, ending on end unless it is noIndex.
+	bool repairTour( int const* tour, const unsigned& start, const unsigned& end );
+
+	//the places low up to high in the old tour that have to change, whichever way it is taken.
+	void findDisruption( const std::vector<unsigned>& old, const std::vector<unsigned>& place, const std::vector<unsigned>& extra,
+	                     unsigned& low, unsigned& high ) const;
+
+	//widens low up to high to take in a new start and end, the old tour taken forwards or backwards.
+	void coverEnds( const std::vector<unsigned>& old, const std::vector<unsigned>& place, const unsigned& start,
+	                const unsigned& end, const bool& backward, unsigned& low, unsigned& high ) const;
+
+	//searches the old tour again from first up to last, keeping the rest.
+	bool repairSpan( RepairPath& path, const std::vector<unsigned>& old, const std::vector<unsigned>& extra,
+	                 const unsigned& start, const unsigned& end, const unsigned& first, const unsigned& last, const bool& whole );
+
+	//the old tour's next square from index, away from from, that is still off the path.
+	unsigned nextLink( const RepairPath& path, const unsigned& index, const unsigned& from ) const;
+
+	//which way from index the longer (or shorter) stretch of the old tour off the path goes.
+	unsigned chooseLink( const RepairPath& path, const unsigned& index, const bool& longer ) const;
+
+	//puts index on the path, and the stretch of the old tour after it.
+	void appendStretch( RepairPath& path, const unsigned& index, const bool& longer );
+
+	//reverses the end of the path (a Posa rotation), so its new end has a
+	//square off the path to go to, or a move to target.
+	bool rotatePath( RepairPath& path, const unsigned& target, const bool& wander );
+
+	//cuts the path back to a square a move from index.
+	void ejectPath( RepairPath& path, const unsigned& index );
+
+	//looks for rotations in a row that let the path go on.
+	bool searchRotations( RepairPath& path, const unsigned& target );
+
+	//where place on a path of length goes after the rotations on pivots (or came from).
+	unsigned turnPlace( const unsigned* pivots, const unsigned& count, const unsigned& length, unsigned place, const bool& forward ) const;
+
+	//reverses the squares of the path after pivot.
+	void reverseAfter( RepairPath& path, const unsigned& pivot );
+
+	//can the path go on from index, to a square off it or to target.
+	bool canGoOn( const RepairPath& path, const unsigned& index, const unsigned& target ) const;
+
+	//splices the stretch of the old tour through index into the path.
+	bool spliceStretch( RepairPath& path, const unsigned& index );
+
+	//where index is on the path, or offPath, or heldOff.
+	unsigned placeOnPath( const RepairPath& path, const unsigned& index ) const;
+
+	//the squares off the path a move from index.
+	unsigned countOffPath( const RepairPath& path, const unsigned& index ) const;
+
+	//is there a move between the two squares.
+	bool isLeap( const unsigned& from, const unsigned& to ) const;
+	bool isLeap( const Space& a, const Space& b ) const;
+
+	//returns the next value from the seeded generator.
+	unsigned nextRandom( void );
+
+	//finishes the tour from index through the few squares left, if it can.
+	bool finishEndgame( const unsigned& index );
+
+	//searches the region for a path from position through left.
+	bool searchEndgame( const unsigned* adjacent, const unsigned& position, const unsigned& left,
+	                    const unsigned& ends, unsigned* path );
+
+	//writes and reads a snapshot of the search.
+	bool writeCheckpoint( void ) const;
+	bool readCheckpoint( const char* path, std::vector<Frame>& frames );
 
 	//Sets the naive board
+	void setLayout( void );
 	void setMoveBoard( void );
+	//lists the free squares, if an endgame is set.
+	void setFreeSquares( void );
 	void setHeuristicsBoard( void );
 	void setDistanceBoard( void );
+	template< class Jumps >
+	void setNeighbors( bool const *mask, const Jumps& jumps );
+
+	//returns true if the square at index can be landed on.
+	bool isAvailable( const unsigned& index ) const;
+
+	//sets the move number of a square, and its row-major copy.
+	void setMove( const unsigned& index, const int& move );
+
+	//where a square is in the row by row boards.
+	unsigned getRowIndex( const unsigned& index ) const;
 
-	//returns true if the place at row,column can be landed on.
-	bool isAvailable( const Space& space ) const;
+	//copies a board into its row-major view, or returns it when it already is.
+	template< class T >
+	const T* getView( const Table<T>& board, std::vector<T>& view ) const;
 
-	//returns all the next available positions on the board.
-	const MoveContainer getNextAvailable( const unsigned& row, const unsigned& column );
+	//the square the tour is forced to end on, if any.
+	unsigned endIndex_;
+
+	//queues all the next available positions from the frame's square.
+	void getNextAvailable( Frame& frame );
+
+	//takes the move on top of the frame's queue off it.
+	void popMove( Frame& frame ) const;
+
+	//sums the heuristics of the spaces reachable from index.
+	int getLookahead( const unsigned& index ) const;
 
 	//checks the board to see if all spots on the board have been reached.
 	bool isSolved( void ) const;
 
+	//asks the callback if the search should stop.
+	bool isAborted( void );
+
 };
 
 class Search
@@ -142,8 +488,30 @@ private:
 
 public:
 	Search( const GameBoard* gameboard );
-	bool operator()( const Space& lhs, const Space& rhs ) const;
+	bool operator()( const unsigned& lhs, const unsigned& rhs ) const;
 	const Search& operator=( const Search& rhs );
 };
 
+//What the search keeps for each square it has placed.
+struct GameBoard::Frame
+{
+	//the square.
+	unsigned index;
+	//the moves from it not tried yet, a heap ordered by Search with the
+	//one being tried on top.
+	unsigned moves[maxMoves];
+	unsigned moveCount;
+	//the squares that have to be moved to next or ended on (~0u is none).
+	unsigned forced[2];
+	unsigned forcedCount;
+	//the end square before any of the moves from here.
+	unsigned previousEnd;
+
+	Frame( void )
+	:	index(0), moveCount(0), forcedCount(0), previousEnd(~0u)
+	{
+		forced[0] = forced[1] = ~0u;
+	}
+};
+
 #endif  // GAMEBOARDH
@@ -0,0 +1,496 @@
+/******************************************************************************/
+/*!
+\file   HamiltonianSolver.h
+\brief
+This is the declaration file for the class template HamiltonianSolver, a
+Warnsdorff search over any sparse graph, and for CsrGraph, a graph kept as
+compressed sparse rows.
+
+A graph handed to HamiltonianSolver provides:
+
+  unsigned GetVertices() const;     // the vertices are 0 up to this
+  unsigned GetMaxDegree() const;    // the most neighbors any vertex has
+  bool IsOpen(unsigned v) const;    // false for a vertex the path skips
+  unsigned GetRank(unsigned v) const; // ties go to the highest rank
+  template< class Visit >
+  void ForEachNeighbor(unsigned v, Visit visit) const; // visit(n) for each open neighbor
+
+ForEachNeighbor is a template, so the solver's loops are compiled around
+each graph's own neighbor lists, with no call per neighbor. The pruning and
+ordering of candidates are GameBoard's own, from TourRules.h. The search
+loop is the solver's: it has none of GameBoard's callback, checkpoints,
+endgame, restarts or stepping.
+
+*/
+/******************************************************************************/
+
+//---------------------------------------------------------------------------
+#ifndef HAMILTONIANSOLVERH
+#define HAMILTONIANSOLVERH
+//---------------------------------------------------------------------------
+
+#include "TourRules.h"
+#include <algorithm>
+#include <vector>
+
+// A graph as compressed sparse rows: the neighbors of vertex v are
+// targets[ offsets[v] ] up to targets[ offsets[v+1] ]. Every vertex is open.
+class CsrGraph
+{
+  public:
+      // ranks has one entry per vertex, or none to leave every tie to the
+      // order of the neighbor lists.
+    CsrGraph(const std::vector<unsigned>& offsets, const std::vector<unsigned>& targets,
+             const std::vector<unsigned>& ranks = std::vector<unsigned>())
+    : offsets_(offsets), targets_(targets), ranks_(ranks), maxDegree_(0)
+    {
+      for( unsigned v=0; v<GetVertices(); v++ )
+        maxDegree_ = std::max( maxDegree_, offsets_[v+1] - offsets_[v] );
+    }
+
+    unsigned GetVertices(void) const { return offsets_.empty() ? 0 : static_cast<unsigned>(offsets_.size() - 1); }
+    unsigned GetMaxDegree(void) const { return maxDegree_; }
+    bool IsOpen(unsigned) const { return true; }
+    unsigned GetRank(unsigned v) const { return ranks_.empty() ? 0 : ranks_[v]; }
+
+    template< class Visit >
+    void ForEachNeighbor(unsigned v, Visit visit) const
+    {
+      const unsigned *neighbor = targets_.data() + offsets_[v];
+      const unsigned *const last = targets_.data() + offsets_[v+1];
+      for( ; neighbor != last; ++neighbor )
+        visit( *neighbor );
+    }
+
+  private:
+    std::vector<unsigned> offsets_;
+    std::vector<unsigned> targets_;
+    std::vector<unsigned> ranks_;
+    unsigned maxDegree_;
+};
+
+template< class Graph >
+class HamiltonianSolver
+{
+  public:
+    enum Ordering
+    {
+      hoNONE,     // neighbors in the graph's order, dead ends pruned
+      hoDEGREE,   // fewest onward moves first, then the highest rank
+      hoLOOKAHEAD // as hoDEGREE, then the lowest sum of the neighbors' degrees
+    };
+
+      // The graph has to outlive the solver.
+    explicit HamiltonianSolver(const Graph& graph);
+
+      // Looks for a path from start through every open vertex, giving up
+      // once budget vertices have been placed.
+    bool Solve(unsigned start, Ordering ordering = hoDEGREE, unsigned long long budget = ~0ULL);
+
+    const std::vector<unsigned>& GetPath(void) const; // the path found, or only the start
+    unsigned long long GetMoves(void) const;          // vertices placed, counting those taken back
+
+  private:
+    //a vertex, as the search reads it: its place on the path (0 free), its
+    //free neighbors, its rank, and its last second-level degree sum.
+    struct Vertex
+    {
+      unsigned order;
+      unsigned degree;
+      unsigned rank;
+      int lookahead;
+    };
+
+    //a vertex on the path, with the candidates left to try from it and the
+    //neighbors that have to come next or last.
+    struct Frame
+    {
+      unsigned vertex;
+      unsigned candidates;
+      unsigned forced;
+      unsigned previousEnd;
+    };
+
+    static const unsigned noVertex = ~0u;
+    static const unsigned blocked = ~0u;
+
+    const Graph& graph_;
+    Ordering ordering_;
+    unsigned open_;
+    unsigned end_;
+    unsigned long long moves_;
+
+    std::vector<Vertex> vertices_;
+    std::vector<unsigned> path_;
+    std::vector<Frame> frames_;
+    //one stretch per frame: a heap of its candidates, then its forced vertices.
+    std::vector<unsigned> slots_;
+    unsigned stride_;
+
+    //puts v on the path and lists its candidates. True once the path is whole.
+    bool place(unsigned v);
+
+    //lists the free neighbors of v, best first, and the ones forced on the path.
+    unsigned expand(unsigned v, unsigned *candidates, unsigned *forced, unsigned& forcedCount);
+
+    //fills in the second-level sums of the vertices tied on degree.
+    void setLookahead(unsigned const *vertices, unsigned count);
+
+    //the sum of the degrees of v's free neighbors.
+    int lookahead(unsigned v) const;
+
+    //true when lhs is to be tried after rhs.
+    bool after(unsigned lhs, unsigned rhs) const;
+
+    HamiltonianSolver(const HamiltonianSolver&);
+    HamiltonianSolver& operator=(const HamiltonianSolver&);
+};
+
+/******************************************************************************/
+/*!
+
+Constructs a solver for a graph.
+
+\param graph
+The graph to search. Read, never changed.
+
+*/
+/******************************************************************************/
+template< class Graph >
+HamiltonianSolver<Graph>::HamiltonianSolver(const Graph& graph)
+:	graph_(graph), ordering_(hoDEGREE), open_(0), end_(noVertex), moves_(0),
+	vertices_(graph.GetVertices()), stride_(2 * graph.GetMaxDegree())
+{
+}
+
+/******************************************************************************/
+/*!
+
+Looks for a path from start through every open vertex. Candidates are
+pruned and tried in the order GameBoard's search tries squares, so on a
+board's graph it finds KnightsTour's tour in as many moves.
+
+\param start
+The vertex the path starts on.
+
+\param ordering
+How the neighbors are ordered.
+
+\param budget
+The most vertices to place before giving up.
+
+\return
+If a path was found or not.
+
+*/
+/******************************************************************************/
+template< class Graph >
+bool HamiltonianSolver<Graph>::Solve(unsigned start, Ordering ordering, unsigned long long budget)
+{
+	ordering_ = ordering;
+	moves_ = 0;
+	end_ = noVertex;
+	path_.clear();
+	frames_.clear();
+
+	open_ = 0;
+	for( unsigned v=0; v<vertices_.size(); v++ )
+	{
+		Vertex& vertex = vertices_[v];
+		vertex.order = graph_.IsOpen( v ) ? 0 : blocked;
+		vertex.degree = 0;
+		vertex.rank = graph_.GetRank( v );
+		vertex.lookahead = 0;
+
+		if( !vertex.order )
+		{
+			++open_;
+			graph_.ForEachNeighbor( v, [&vertex](unsigned) { ++vertex.degree; } );
+		}
+	}
+
+	if( start >= vertices_.size() || vertices_[start].order )
+		return false;
+
+	if( place( start ) )
+		return true;
+
+	const auto compare = [this](unsigned lhs, unsigned rhs) { return after( lhs, rhs ); };
+
+	while( !frames_.empty() )
+	{
+		const unsigned depth = static_cast<unsigned>(frames_.size() - 1);
+		Frame& frame = frames_[depth];
+		unsigned *heap = slots_.data() + depth * stride_;
+
+		//every candidate failed: the frame below takes this vertex back.
+		if( !frame.candidates )
+		{
+			frames_.pop_back();
+			if( frames_.empty() )
+				break;
+
+			Frame& below = frames_.back();
+			unsigned *belowHeap = slots_.data() + (depth - 1) * stride_;
+			const unsigned failed = belowHeap[0];
+
+			path_.pop_back();
+			vertices_[failed].order = 0;
+
+			//the frames above overwrote the sums the heap is ordered by.
+			if( ordering_ == hoLOOKAHEAD )
+				setLookahead( belowHeap, below.candidates );
+
+			if( ordering_ != hoLOOKAHEAD || std::is_heap( belowHeap, belowHeap + below.candidates, compare ) )
+				std::pop_heap( belowHeap, belowHeap + below.candidates, compare );
+			else
+			{
+				//candidates that are neighbors of each other change each
+				//other's sums, so the heap is built again without the failed one.
+				std::swap( belowHeap[0], belowHeap[below.candidates - 1] );
+				std::make_heap( belowHeap, belowHeap + below.candidates - 1, compare );
+			}
+			--below.candidates;
+
+			end_ = below.previousEnd;
+			++vertices_[failed].degree;
+			continue;
+		}
+
+		//out of budget: the search unwinds to the start, as GameBoard's does.
+		if( moves_ >= budget )
+		{
+			path_.resize( 1 );
+			return false;
+		}
+
+		//a forced vertex not moved to now can only be reached at the end.
+		const unsigned next = heap[0];
+		const unsigned *forced = heap + stride_ / 2;
+		for( unsigned i=0; i<frame.forced; i++ )
+		{
+			if( forced[i] != next )
+				end_ = forced[i];
+		}
+
+		if( place( next ) )
+			return true;
+	}
+
+	return false;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the path found. A search that failed, or ran out of budget, leaves
+only the start.
+
+\return
+The vertices of the path, in order.
+
+*/
+/******************************************************************************/
+template< class Graph >
+const std::vector<unsigned>& HamiltonianSolver<Graph>::GetPath(void) const
+{
+	return path_;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the vertices placed by the last search, counting every one that
+was taken back.
+
+\return
+The number of vertices placed.
+
+*/
+/******************************************************************************/
+template< class Graph >
+unsigned long long HamiltonianSolver<Graph>::GetMoves(void) const
+{
+	return moves_;
+}
+
+/******************************************************************************/
+/*!
+
+Puts a vertex on the path, and gives it a frame of candidates unless the
+path is whole.
+
+\param v
+The vertex.
+
+\return
+If every open vertex is on the path.
+
+*/
+/******************************************************************************/
+template< class Graph >
+bool HamiltonianSolver<Graph>::place(unsigned v)
+{
+	++moves_;
+	path_.push_back( v );
+	vertices_[v].order = static_cast<unsigned>(path_.size());
+
+	if( path_.size() == open_ )
+		return true;
+
+	const unsigned depth = static_cast<unsigned>(frames_.size());
+	if( slots_.size() < ( depth + 1 ) * static_cast<size_t>(stride_) )
+		slots_.resize( ( depth + 1 ) * static_cast<size_t>(stride_) * 2 );
+
+	Frame frame;
+	frame.vertex = v;
+	frame.forced = 0;
+	//a graph with no edges has no slots, and its frames no candidates.
+	unsigned *heap = slots_.data() + depth * stride_;
+	frame.candidates = expand( v, heap, heap + stride_ / 2, frame.forced );
+	frame.previousEnd = end_;
+	frames_.push_back( frame );
+
+	return false;
+}
+
+/******************************************************************************/
+/*!
+
+Lists the free neighbors of a vertex as a heap, the best candidate on top,
+and takes one from the degree of each.
+
+\param v
+The vertex.
+
+\param candidates
+Receives the heap of candidates.
+
+\param forced
+Receives the candidates that have to be moved to next or ended on.
+
+\param forcedCount
+Receives the number of forced candidates.
+
+\return
+The number of candidates.
+
+*/
+/******************************************************************************/
+template< class Graph >
+unsigned HamiltonianSolver<Graph>::expand(unsigned v, unsigned *candidates, unsigned *forced, unsigned& forcedCount)
+{
+	unsigned count = 0;
+
+	graph_.ForEachNeighbor( v, [this, candidates, &count](unsigned n)
+	{
+		if( !vertices_[n].order )
+		{
+			--vertices_[n].degree;
+			candidates[count++] = n;
+		}
+	} );
+
+	count = PruneDeadEnds( candidates, count, open_ - static_cast<unsigned>(path_.size()), end_,
+	                       [this](unsigned n) { return vertices_[n].degree; },
+	                       [this](unsigned n) { ++vertices_[n].degree; }, forced, forcedCount );
+
+	if( ordering_ == hoLOOKAHEAD )
+		setLookahead( candidates, count );
+
+	const auto compare = [this](unsigned lhs, unsigned rhs) { return after( lhs, rhs ); };
+	for( unsigned i=1; i<count; i++ )
+		std::push_heap( candidates, candidates + i + 1, compare );
+
+	return count;
+}
+
+/******************************************************************************/
+/*!
+
+Works out the second-level sums of the vertices that tie with another on
+both degree and rank. A frame calls this again for the candidates it has
+left once the one it tried is taken back, since the frames above overwrote
+their sums. The sums come out as they were listed with as long as no two
+neighbors of a vertex are neighbors themselves, as on a leaper's graph.
+Otherwise the frame rebuilds its heap.
+
+\param vertices
+The vertices.
+
+\param count
+The number of vertices.
+
+*/
+/******************************************************************************/
+template< class Graph >
+void HamiltonianSolver<Graph>::setLookahead(unsigned const *vertices, unsigned count)
+{
+	ForEachTie( vertices, count, [this](unsigned n) { return vertices_[n].degree; },
+	            [this](unsigned n) { return vertices_[n].rank; },
+	            [this](unsigned n) { vertices_[n].lookahead = lookahead( n ); } );
+}
+
+/******************************************************************************/
+/*!
+
+Sums the degrees of a vertex's free neighbors, Pohl's tie-break.
+
+\param v
+The vertex.
+
+\return
+The second-level degree sum.
+
+*/
+/******************************************************************************/
+template< class Graph >
+int HamiltonianSolver<Graph>::lookahead(unsigned v) const
+{
+	int sum = 0;
+
+	graph_.ForEachNeighbor( v, [this, &sum](unsigned n)
+	{
+		if( !vertices_[n].order )
+			sum += static_cast<int>(vertices_[n].degree);
+	} );
+
+	return sum;
+}
+
+/******************************************************************************/
+/*!
+
+Orders two candidates by CompareCandidates, as Search does for GameBoard,
+breaking its ties (with hoLOOKAHEAD) by the lower second-level sum.
+Candidates that tie keep the heap's order.
+
+\param lhs
+One candidate.
+
+\param rhs
+The other candidate.
+
+\return
+True when lhs is to be tried after rhs.
+
+*/
+/******************************************************************************/
+template< class Graph >
+bool HamiltonianSolver<Graph>::after(unsigned lhs, unsigned rhs) const
+{
+	if( ordering_ == hoNONE )
+		return false;
+
+	const Vertex& left = vertices_[lhs];
+	const Vertex& right = vertices_[rhs];
+
+	return CompareCandidates( left.degree, left.rank, right.degree, right.rank, [this, &left, &right]()
+	{
+		if( ordering_ != hoLOOKAHEAD || left.lookahead == right.lookahead )
+			return 0;
+		return left.lookahead < right.lookahead ? -1 : 1;
+	}, []() { return 0; } ) > 0;
+}
+
+#endif  // HAMILTONIANSOLVERH
@@ -0,0 +1,76 @@
+/******************************************************************************/
+/*!
+\file   KnightGraph.h
+\brief
+This is the declaration file for the class KnightGraph, which hands the
+squares and moves of a GameBoard to HamiltonianSolver.
+
+*/
+/******************************************************************************/
+
+//---------------------------------------------------------------------------
+#ifndef KNIGHTGRAPHH
+#define KNIGHTGRAPHH
+//---------------------------------------------------------------------------
+
+#include "GameBoard.h"
+#include <algorithm>
+
+// The squares of a board as vertices, in the board's storage order, and its
+// piece's moves as edges, in jump order. A path found on it is the tour
+// KnightsTour finds, square for square.
+class KnightGraph
+{
+  public:
+      // Reads board's tables as they are; board has to outlive the graph.
+    explicit KnightGraph(const GameBoard& board)
+    : board_(board), starts_(board.GetNeighborStarts()), neighbors_(board.GetNeighbors()), maxDegree_(0)
+    {
+      for( unsigned v=0; v<board_.size_; v++ )
+        maxDegree_ = std::max( maxDegree_, starts_[v+1] - starts_[v] );
+    }
+
+    unsigned GetVertices(void) const { return board_.size_; }
+    unsigned GetMaxDegree(void) const { return maxDegree_; }
+    bool IsOpen(unsigned v) const { return !( board_.masked_ && board_.blocked_[v] ); }
+    unsigned GetRank(unsigned v) const { return board_.cells_[v].rank; }
+
+    template< class Visit >
+    void ForEachNeighbor(unsigned v, Visit visit) const
+    {
+      const unsigned *neighbor = neighbors_ + starts_[v];
+      const unsigned *const last = neighbors_ + starts_[v+1];
+      for( ; neighbor != last; ++neighbor )
+        visit( *neighbor );
+    }
+
+      // The vertex of row,column, and back.
+    unsigned GetVertex(unsigned row, unsigned column) const { return board_.get1DIndex( row, column ); }
+    Space GetSpace(unsigned v) const { return board_.get2DSpace( v ); }
+
+      // Writes path to board (rows*columns ints) row by row, as GetBoard
+      // shows a tour: the move number of each square, 0 if not reached and
+      // -1 if blocked.
+    void GetBoard(const std::vector<unsigned>& path, int *board) const
+    {
+      for( unsigned v=0; v<board_.size_; v++ )
+      {
+        const Space space = board_.get2DSpace( v );
+        board[ space.getRow() * board_.columns_ + space.getColumn() ] = IsOpen( v ) ? 0 : -1;
+      }
+
+      for( unsigned i=0; i<path.size(); i++ )
+      {
+        const Space space = board_.get2DSpace( path[i] );
+        board[ space.getRow() * board_.columns_ + space.getColumn() ] = static_cast<int>(i + 1);
+      }
+    }
+
+  private:
+    const GameBoard& board_;
+    unsigned const *starts_;
+    unsigned const *neighbors_;
+    unsigned maxDegree_;
+};
+
+#endif  // KNIGHTGRAPHH
@@ -0,0 +1,705 @@
+/******************************************************************************/
+/*!
+\file   TourCounter.cpp
+\brief
+This is the implementation file for the class TourCounter.
+
+The tours from a start are split into jobs, one for each way the first few
+moves can go, and the jobs are counted on separate threads. Each job is a
+plain depth-first search that prunes with the same dead-end rules as
+GameBoard, so no tour is missed and no dead branch is followed far.
+
+*/
+/******************************************************************************/
+
+#include "TourCounter.h"
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+//No magic numbers in my house.
+const unsigned noIndex = ~0u;
+//A count is split until it has at least this many jobs, so uneven subtrees
+//even out across up to 64 threads and checkpoints lose little work. The
+//split doesn't depend on the threads, so a count checkpointed on some can
+//be carried on with any other number of them.
+const unsigned minJobs = 4096;
+//and no further than this many squares deep.
+const unsigned maxDepth = 16;
+//The symmetries of a rectangle, the last four only for squares.
+const unsigned numSymmetries = 8;
+
+//The state of one depth-first count.
+struct TourCounter::Walk
+{
+	//which squares the walk has been on (blocked squares count as visited).
+	std::vector<char> visited;
+	//the neighbors of each square the walk has not been on.
+	std::vector<unsigned> degree;
+	//the squares in the order they were visited.
+	std::vector<unsigned> path;
+	unsigned start;
+	//the squares left to visit.
+	unsigned remaining;
+};
+
+/******************************************************************************/
+/*!
+
+Copies the board's neighbor lists and mask, so the counter does not depend
+on the board afterwards.
+
+\param board
+The board, with its piece and mask, to count the tours of.
+
+\param closed
+If only tours that end a move away from their start are counted.
+
+\param threads
+The number of threads to count on, 0 for one per core.
+
+*/
+/******************************************************************************/
+TourCounter::TourCounter(const GameBoard& board, bool closed, unsigned threads)
+:	rows_(board.GetRows()), columns_(board.GetColumns()), squares_(board.GetSquares()),
+	shortLeap_(board.GetShortLeap()), longLeap_(board.GetLongLeap()),
+	closed_(closed), threads_(threads),
+	neighborStart_(), neighbors_(), blocked_(rows_ * columns_), maskHash_(board.GetMaskHash()), checkpoint_(),
+	seconds_(0), depth_(0), jobs_(),
+	resumed_(0)
+{
+	if( !threads_ )
+		threads_ = std::thread::hardware_concurrency();
+	if( !threads_ )
+		threads_ = 1;
+
+	//the board's lists, whatever its layout, are copied row by row.
+	const unsigned* starts = board.GetNeighborStarts();
+	const unsigned* neighbors = board.GetNeighbors();
+	neighborStart_.reserve( rows_ * columns_ + 1 );
+
+	for( unsigned r=0; r<rows_; r++ )
+	{
+		for( unsigned c=0; c<columns_; c++ )
+		{
+			const unsigned index = board.get1DIndex( r, c );
+			neighborStart_.push_back( static_cast<unsigned>(neighbors_.size()) );
+			blocked_[ r * columns_ + c ] = board.IsBlocked( r, c );
+
+			for( unsigned i=starts[index]; i<starts[index+1]; i++ )
+			{
+				const Space space = board.get2DSpace( neighbors[i] );
+				neighbors_.push_back( space.getRow() * columns_ + space.getColumn() );
+			}
+		}
+	}
+
+	neighborStart_.push_back( static_cast<unsigned>(neighbors_.size()) );
+}
+
+/******************************************************************************/
+/*!
+
+Counts every tour starting at row,column.
+
+\param row
+The row coordinate of the start.
+
+\param column
+The column coordinate of the start.
+
+\return
+The number of tours. A closed tour is counted once in each direction.
+
+*/
+/******************************************************************************/
+unsigned long long TourCounter::CountFrom(unsigned row, unsigned column)
+{
+	resumed_ = 0;
+	return countJobs( checkpoint_, row * columns_ + column );
+}
+
+/******************************************************************************/
+/*!
+
+Counts the tours starting on every square. A square that one of the board's
+symmetries (that also leaves the mask as it is) maps onto a square already
+counted has as many tours, so it is copied rather than counted.
+
+\param counts
+rows*columns entries, row by row, that get the tours from each square.
+
+\return
+The number of tours on the board, counted from every start.
+
+*/
+/******************************************************************************/
+unsigned long long TourCounter::CountAll(unsigned long long *counts)
+{
+	const unsigned size = rows_ * columns_;
+	resumed_ = 0;
+
+	//the symmetries the board and its mask have.
+	bool symmetric[numSymmetries];
+	for( unsigned s=1; s<numSymmetries; s++ )
+	{
+		unsigned image = 0;
+		symmetric[s] = true;
+		for( unsigned i=0; i<size && symmetric[s]; i++ )
+			symmetric[s] = transform( s, i, image ) && blocked_[image] == blocked_[i];
+	}
+
+	unsigned long long total = 0;
+	for( unsigned i=0; i<size; i++ )
+	{
+		counts[i] = 0;
+		if( blocked_[i] )
+			continue;
+
+		bool copied = false;
+		for( unsigned s=1; s<numSymmetries && !copied; s++ )
+		{
+			unsigned image = 0;
+			if( symmetric[s] && transform( s, i, image ) && image < i )
+			{
+				counts[i] = counts[image];
+				copied = true;
+			}
+		}
+
+		if( !copied )
+		{
+			std::string path = checkpoint_;
+			if( !path.empty() )
+			{
+				char suffix[32];
+				sprintf( suffix, ".%u.%u", i / columns_, i % columns_ );
+				path += suffix;
+			}
+			counts[i] = countJobs( path, i );
+		}
+
+		total += counts[i];
+	}
+
+	return total;
+}
+
+/******************************************************************************/
+/*!
+
+Keeps a record of the finished jobs in path. A count that finds a record of
+the same board, start and jobs there only counts the jobs it is missing, so
+a long count that is stopped can be carried on.
+
+\param path
+The file to keep the record in, or 0 to keep none.
+
+\param seconds
+How long to wait between writing the record.
+
+*/
+/******************************************************************************/
+void TourCounter::SetCheckpoint(const char *path, unsigned seconds)
+{
+	checkpoint_ = path ? path : "";
+	seconds_ = seconds;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the number of jobs the last count was split into.
+
+\return
+The number of jobs.
+
+*/
+/******************************************************************************/
+unsigned TourCounter::GetJobs(void) const
+{
+	return static_cast<unsigned>(jobs_.size());
+}
+
+/******************************************************************************/
+/*!
+
+Returns the number of jobs the last count read from its checkpoint instead
+of counting.
+
+\return
+The number of jobs resumed.
+
+*/
+/******************************************************************************/
+unsigned TourCounter::GetResumed(void) const
+{
+	return resumed_;
+}
+
+/******************************************************************************/
+/*!
+
+Splits the tours from start into jobs, deepening the split until there are
+enough of them, and counts the jobs on threads_ threads. The split only
+depends on the board and start, so the jobs a checkpoint records are the
+same ones whatever threads_ was when it was written.
+
+\param path
+The checkpoint file, empty for none.
+
+\param start
+The 1-D index of the start.
+
+\return
+The number of tours from start.
+
+*/
+/******************************************************************************/
+unsigned long long TourCounter::countJobs(const std::string& path, unsigned start)
+{
+	jobs_.clear();
+	depth_ = 0;
+	if( blocked_[start] )
+		return 0;
+
+	do
+	{
+		++depth_;
+		makeJobs( start, depth_ );
+	} while( jobs_.size() < minJobs && depth_ < maxDepth && depth_ < squares_ );
+
+	std::vector<bool> done( jobs_.size(), false );
+	std::vector<unsigned long long> counts( jobs_.size(), 0 );
+	if( !path.empty() )
+		readCheckpoint( path, start, done, counts );
+	for( unsigned i=0; i<done.size(); i++ )
+		resumed_ += done[i] ? 1 : 0;
+
+	//the jobs that were already done, read without the lock.
+	const std::vector<bool> resumed = done;
+
+	std::atomic<unsigned> next( 0 );
+	std::mutex lock;
+	std::chrono::steady_clock::time_point written = std::chrono::steady_clock::now();
+
+	auto worker = [&]()
+	{
+		for( ;; )
+		{
+			const unsigned job = next++;
+			if( job >= jobs_.size() )
+				return;
+			if( resumed[job] )
+				continue;
+
+			const unsigned long long count = countJob( jobs_[job] );
+
+			std::lock_guard<std::mutex> guard( lock );
+			counts[job] = count;
+			done[job] = true;
+
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if( !path.empty() && now - written >= std::chrono::seconds( seconds_ ) )
+			{
+				writeCheckpoint( path, start, done, counts );
+				written = now;
+			}
+		}
+	};
+
+	if( threads_ == 1 )
+		worker();
+	else
+	{
+		std::vector<std::thread> workers;
+		for( unsigned i=0; i<threads_; i++ )
+			workers.push_back( std::thread( worker ) );
+		for( unsigned i=0; i<threads_; i++ )
+			workers[i].join();
+	}
+
+	if( !path.empty() )
+		writeCheckpoint( path, start, done, counts );
+
+	unsigned long long total = 0;
+	for( unsigned i=0; i<counts.size(); i++ )
+		total += counts[i];
+
+	return total;
+}
+
+/******************************************************************************/
+/*!
+
+Lists every path of depth squares from start that the pruning allows as a
+job. Tours shorter than depth are listed whole.
+
+\param start
+The 1-D index of the start.
+
+\param depth
+The number of squares in each job's path.
+
+*/
+/******************************************************************************/
+void TourCounter::makeJobs(unsigned start, unsigned depth)
+{
+	const unsigned size = rows_ * columns_;
+
+	Walk walk;
+	walk.visited.assign( size, 0 );
+	walk.degree.assign( size, 0 );
+	walk.start = start;
+	walk.remaining = squares_;
+	for( unsigned i=0; i<size; i++ )
+	{
+		walk.visited[i] = blocked_[i];
+		walk.degree[i] = neighborStart_[i + 1] - neighborStart_[i];
+	}
+
+	jobs_.clear();
+	visit( walk, start );
+	countFrom( walk, start, noIndex, depth, &jobs_ );
+}
+
+/******************************************************************************/
+/*!
+
+Walks a job's path and counts the tours that carry on from its end.
+
+\param job
+The job to count.
+
+\return
+The number of tours that start with the job's path.
+
+*/
+/******************************************************************************/
+unsigned long long TourCounter::countJob(const Job& job) const
+{
+	const unsigned size = rows_ * columns_;
+
+	Walk walk;
+	walk.visited.assign( size, 0 );
+	walk.degree.assign( size, 0 );
+	walk.start = job.path[0];
+	walk.remaining = squares_;
+	for( unsigned i=0; i<size; i++ )
+	{
+		walk.visited[i] = blocked_[i];
+		walk.degree[i] = neighborStart_[i + 1] - neighborStart_[i];
+	}
+
+	for( unsigned i=0; i<job.path.size(); i++ )
+		visit( walk, job.path[i] );
+
+	return countFrom( walk, job.path.back(), job.end, 0, 0 );
+}
+
+/******************************************************************************/
+/*!
+
+Counts the tours that carry on from index, the walk's last square.
+
+A square next to index with no other way in can only be the next move, and
+only when it is the last square. A square with one other way in has to be
+the next move or the end of the tour; an open tour has one end to give out,
+which is kept in end, and a closed tour has none.
+
+\param walk
+The walk so far.
+
+\param index
+The 1-D index of the square the walk is on.
+
+\param end
+The square the tour has to end on, or noIndex.
+
+\param depth
+The length of walk at which to list it as a job instead, when jobs is set.
+
+\param jobs
+Where to list the jobs, or 0 to count the tours.
+
+\return
+The number of tours from here.
+
+*/
+/******************************************************************************/
+unsigned long long TourCounter::countFrom(Walk& walk, unsigned index, unsigned end,
+                                          unsigned depth, std::vector<Job>* jobs) const
+{
+	if( jobs && walk.path.size() == depth )
+	{
+		Job job;
+		job.path = walk.path;
+		job.end = end;
+		jobs->push_back( job );
+		return 0;
+	}
+
+	const unsigned first = neighborStart_[index];
+	const unsigned last = neighborStart_[index + 1];
+
+	if( !walk.remaining )
+	{
+		if( !closed_ )
+			return 1;
+
+		for( unsigned i=first; i<last; i++ )
+			if( neighbors_[i] == walk.start )
+				return 1;
+		return 0;
+	}
+
+	//a closed tour can't get back to a start with no way in.
+	if( closed_ && !walk.degree[walk.start] )
+		return 0;
+
+	//the squares that have to be the next move or the end.
+	unsigned forced[2];
+	unsigned forcedCount = 0;
+	const unsigned ends = closed_ || end != noIndex ? 1 : 2;
+
+	for( unsigned i=first; i<last; i++ )
+	{
+		const unsigned next = neighbors_[i];
+		if( walk.visited[next] || walk.remaining == 1 )
+			continue;
+
+		if( !walk.degree[next] )
+			return 0;
+
+		if( walk.degree[next] == 1 && next != end )
+		{
+			if( forcedCount == ends )
+				return 0;
+			forced[forcedCount++] = next;
+		}
+	}
+
+	unsigned long long count = 0;
+	for( unsigned i=first; i<last; i++ )
+	{
+		const unsigned next = neighbors_[i];
+		if( walk.visited[next] || ( next == end && walk.remaining > 1 ) )
+			continue;
+
+		unsigned nextEnd = end;
+		if( forcedCount == 2 )
+		{
+			if( next == forced[0] )
+				nextEnd = forced[1];
+			else if( next == forced[1] )
+				nextEnd = forced[0];
+			else
+				continue;
+		}
+		else if( forcedCount == 1 && next != forced[0] )
+		{
+			if( ends == 1 )
+				continue;
+			nextEnd = forced[0];
+		}
+
+		visit( walk, next );
+		count += countFrom( walk, next, nextEnd, depth, jobs );
+		leave( walk, next );
+	}
+
+	return count;
+}
+
+/******************************************************************************/
+/*!
+
+Moves the walk onto a square, taking a way in away from its neighbors. A
+closed tour has to get back to its start, so the start keeps its way in.
+
+\param walk
+The walk to move.
+
+\param index
+The 1-D index of the square.
+
+*/
+/******************************************************************************/
+void TourCounter::visit(Walk& walk, unsigned index) const
+{
+	walk.visited[index] = 1;
+	walk.path.push_back( index );
+	--walk.remaining;
+
+	if( closed_ && index == walk.start )
+		return;
+
+	for( unsigned i=neighborStart_[index]; i<neighborStart_[index + 1]; i++ )
+		--walk.degree[ neighbors_[i] ];
+}
+
+/******************************************************************************/
+/*!
+
+Moves the walk back off its last square.
+
+\param walk
+The walk to move.
+
+\param index
+The 1-D index of the square.
+
+*/
+/******************************************************************************/
+void TourCounter::leave(Walk& walk, unsigned index) const
+{
+	walk.visited[index] = 0;
+	walk.path.pop_back();
+	++walk.remaining;
+
+	if( closed_ && index == walk.start )
+		return;
+
+	for( unsigned i=neighborStart_[index]; i<neighborStart_[index + 1]; i++ )
+		++walk.degree[ neighbors_[i] ];
+}
+
+/******************************************************************************/
+/*!
+
+Reads the finished jobs from a checkpoint. A file made for another board
+(one blocked elsewhere included), start or split is ignored.
+
+\param path
+The checkpoint file.
+
+\param start
+The 1-D index of the start.
+
+\param done
+Set for each job the file has a count for.
+
+\param counts
+The count of each job the file has.
+
+\return
+If the file was for this count.
+
+*/
+/******************************************************************************/
+bool TourCounter::readCheckpoint(const std::string& path, unsigned start,
+                                 std::vector<bool>& done, std::vector<unsigned long long>& counts) const
+{
+	FILE *file = fopen( path.c_str(), "r" );
+	if( !file )
+		return false;
+
+	unsigned header[8];
+	const unsigned expected[8] = { rows_, columns_, shortLeap_, longLeap_, closed_,
+	                               start, depth_, static_cast<unsigned>(jobs_.size()) };
+	unsigned long long maskHash = 0;
+
+	bool match = fscanf( file, "tours %u %u %u %u %u %u %u %u %llx", &header[0], &header[1], &header[2],
+	                     &header[3], &header[4], &header[5], &header[6], &header[7], &maskHash ) == 9 &&
+	             maskHash == maskHash_;
+	for( unsigned i=0; i<8 && match; i++ )
+		match = header[i] == expected[i];
+
+	unsigned job = 0;
+	unsigned long long count = 0;
+	while( match && fscanf( file, "%u %llu", &job, &count ) == 2 )
+	{
+		if( job < done.size() )
+		{
+			done[job] = true;
+			counts[job] = count;
+		}
+	}
+
+	fclose( file );
+	return match;
+}
+
+/******************************************************************************/
+/*!
+
+Writes the finished jobs to a checkpoint. The file is written beside path
+and renamed over it, so a count stopped while writing keeps the last one.
+
+\param path
+The checkpoint file.
+
+\param start
+The 1-D index of the start.
+
+\param done
+Which jobs are finished.
+
+\param counts
+The count of each job.
+
+*/
+/******************************************************************************/
+void TourCounter::writeCheckpoint(const std::string& path, unsigned start,
+                                  const std::vector<bool>& done, const std::vector<unsigned long long>& counts) const
+{
+	const std::string temporary = path + ".tmp";
+	FILE *file = fopen( temporary.c_str(), "w" );
+	if( !file )
+		return;
+
+	fprintf( file, "tours %u %u %u %u %u %u %u %u %llx\n", rows_, columns_, shortLeap_, longLeap_,
+	         closed_ ? 1u : 0u, start, depth_, static_cast<unsigned>(jobs_.size()), maskHash_ );
+	for( unsigned i=0; i<done.size(); i++ )
+		if( done[i] )
+			fprintf( file, "%u %llu\n", i, counts[i] );
+
+	if( fclose( file ) == 0 )
+		rename( temporary.c_str(), path.c_str() );
+}
+
+/******************************************************************************/
+/*!
+
+Maps a square through one of the board's symmetries: 0 is the identity, 1-3
+are the row, column and both flips, and 4-7 are those after swapping rows
+and columns, which only squares have.
+
+\param symmetry
+The symmetry, 0-7.
+
+\param index
+The 1-D index of the square.
+
+\param result
+The 1-D index of the square it maps to.
+
+\return
+If the board has the symmetry.
+
+*/
+/******************************************************************************/
+bool TourCounter::transform(unsigned symmetry, unsigned index, unsigned& result) const
+{
+	if( symmetry >= 4 && rows_ != columns_ )
+		return false;
+
+	unsigned r = index / columns_;
+	unsigned c = index % columns_;
+
+	if( symmetry >= 4 )
+	{
+		const unsigned swap = r;
+		r = c;
+		c = swap;
+	}
+	if( symmetry & 1 )
+		r = rows_ - 1 - r;
+	if( symmetry & 2 )
+		c = columns_ - 1 - c;
+
+	result = r * columns_ + c;
+	return true;
+}
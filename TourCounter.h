@@ -0,0 +1,109 @@
+/******************************************************************************/
+/*!
+\file   TourCounter.h
+\brief
+This is the declaration file for the class TourCounter, which counts every
+open or closed tour of a GameBoard instead of stopping at the first one.
+
+*/
+/******************************************************************************/
+
+//---------------------------------------------------------------------------
+#ifndef TOURCOUNTERH
+#define TOURCOUNTERH
+//---------------------------------------------------------------------------
+
+#include "GameBoard.h"
+#include <string>
+#include <vector>
+
+class TourCounter
+{
+  public:
+      // Counts the tours of board's piece over board's open squares.
+      // threads = 0 uses every core.
+    TourCounter(const GameBoard& board, bool closed = false, unsigned threads = 0);
+
+      // The number of tours starting at row,column. A closed tour is counted
+      // once in each direction.
+    unsigned long long CountFrom(unsigned row, unsigned column);
+
+      // Fills counts (rows*columns entries, row by row) with the tours
+      // starting on each square and returns their sum. Squares that are a
+      // symmetry of the board away from one already counted are copied.
+    unsigned long long CountAll(unsigned long long *counts);
+
+      // Records finished jobs to path as they complete, and skips the jobs a
+      // matching file already records. CountAll adds .row.column to path.
+    void SetCheckpoint(const char *path, unsigned seconds = 10);
+
+      // The number of jobs the last count was split into. The split only
+      // depends on the board and start, never on the threads.
+    unsigned GetJobs(void) const;
+      // The jobs the last count (every start of CountAll) took from its
+      // checkpoint. 0 when a file was for another board, start or split.
+    unsigned GetResumed(void) const;
+
+  private:
+    unsigned rows_;
+    unsigned columns_;
+    unsigned squares_;
+    unsigned shortLeap_;
+    unsigned longLeap_;
+    bool closed_;
+    unsigned threads_;
+
+    //the board's neighbor lists and mask, and the mask's hash.
+    std::vector<unsigned> neighborStart_;
+    std::vector<unsigned> neighbors_;
+    std::vector<bool> blocked_;
+    unsigned long long maskHash_;
+
+    //where progress is kept, and how often it is written.
+    std::string checkpoint_;
+    unsigned seconds_;
+
+    //a prefix of the tours being counted, and the square they must end on.
+    struct Job
+    {
+      std::vector<unsigned> path;
+      unsigned end;
+    };
+
+    //the state of one depth-first count.
+    struct Walk;
+
+    //the prefixes the last count was split into, depth_ squares long.
+    unsigned depth_;
+    std::vector<Job> jobs_;
+    unsigned resumed_;
+
+    //lists every path of depth squares from start as a job.
+    void makeJobs(unsigned start, unsigned depth);
+
+    //counts the tours of one job.
+    unsigned long long countJob(const Job& job) const;
+
+    //counts the tours that carry on from the walk's last square, or lists
+    //them as jobs once the walk is depth squares long.
+    unsigned long long countFrom(Walk& walk, unsigned index, unsigned end,
+                                 unsigned depth, std::vector<Job>* jobs) const;
+
+    //moves the walk onto, and back off, a square.
+    void visit(Walk& walk, unsigned index) const;
+    void leave(Walk& walk, unsigned index) const;
+
+    //counts the jobs on threads_ threads, writing checkpoints to path.
+    unsigned long long countJobs(const std::string& path, unsigned start);
+
+    //reads and writes the finished jobs.
+    bool readCheckpoint(const std::string& path, unsigned start,
+                        std::vector<bool>& done, std::vector<unsigned long long>& counts) const;
+    void writeCheckpoint(const std::string& path, unsigned start,
+                         const std::vector<bool>& done, const std::vector<unsigned long long>& counts) const;
+
+    //maps a square to itself under one of the board's symmetries.
+    bool transform(unsigned symmetry, unsigned index, unsigned& result) const;
+};
+
+#endif  // TOURCOUNTERH
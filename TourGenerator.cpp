@@ -0,0 +1,202 @@
+/******************************************************************************/
+/*!
+\file   TourGenerator.cpp
+\brief
+This is the implementation file for the class TourGenerator.
+
+The coroutine runs GameBoard's search one square at a time, and only
+suspends at the events asked for. Between pulls the whole search is the
+board's stack of frames, so nothing is buffered and no thread is handed
+the board.
+
+*/
+/******************************************************************************/
+
+#include "TourGenerator.h"
+
+/******************************************************************************/
+/*!
+
+The coroutine behind every TourGenerator. Suspends at each tour, and at each
+square placed and taken back when moves is set.
+
+\param board
+The board to search.
+
+\param row
+The row coordinate of the start.
+
+\param column
+The column coordinate of the start.
+
+\param policy
+A type of search to perform.
+
+\param moves
+If every square placed and taken back is yielded, not just the tours.
+
+\return
+The generator, suspended before the first square is placed.
+
+*/
+/******************************************************************************/
+TourGenerator TourGenerator::Tours(GameBoard& board, unsigned row, unsigned column,
+                                   GameBoard::TourPolicy policy, bool moves)
+{
+	Event event;
+	GameBoard::SearchStep step = board.beginSteps( row, column, policy );
+
+	while( step != GameBoard::ssDONE )
+	{
+		if( step == GameBoard::ssTOUR || moves )
+		{
+			if( step == GameBoard::ssTOUR )
+				event.message = GameBoard::MSG_FINISHED_OK;
+			else if( step == GameBoard::ssPLACED )
+				event.message = GameBoard::MSG_PLACING;
+			else
+				event.message = GameBoard::MSG_REMOVING;
+
+			//a square taken back had the move after the one now on top.
+			event.move = static_cast<unsigned>( board.iteration_ ) + ( step == GameBoard::ssREMOVED ? 1 : 0 );
+			event.row = board.currentSpace.getRow();
+			event.column = board.currentSpace.getColumn();
+
+			co_yield event;
+		}
+
+		step = board.nextStep();
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Takes over the coroutine of a generator.
+
+\param handle
+The coroutine.
+
+*/
+/******************************************************************************/
+TourGenerator::TourGenerator(std::coroutine_handle<promise_type> handle)
+:	handle_(handle)
+{
+}
+
+/******************************************************************************/
+/*!
+
+Takes over the coroutine of another generator, leaving it empty.
+
+\param other
+The generator to take from.
+
+*/
+/******************************************************************************/
+TourGenerator::TourGenerator(TourGenerator&& other)
+:	handle_( std::exchange( other.handle_, std::coroutine_handle<promise_type>() ) )
+{
+}
+
+/******************************************************************************/
+/*!
+
+Drops this generator's coroutine and takes over another's.
+
+\param other
+The generator to take from.
+
+\return
+This generator.
+
+*/
+/******************************************************************************/
+TourGenerator& TourGenerator::operator=(TourGenerator&& other)
+{
+	if( this != &other )
+	{
+		if( handle_ )
+			handle_.destroy();
+		handle_ = std::exchange( other.handle_, std::coroutine_handle<promise_type>() );
+	}
+
+	return *this;
+}
+
+/******************************************************************************/
+/*!
+
+Drops the coroutine, wherever it was suspended.
+
+*/
+/******************************************************************************/
+TourGenerator::~TourGenerator()
+{
+	if( handle_ )
+		handle_.destroy();
+}
+
+/******************************************************************************/
+/*!
+
+Resumes the search until its next event.
+
+\return
+False once the search has tried every move from the start.
+
+*/
+/******************************************************************************/
+bool TourGenerator::Next(void)
+{
+	if( !handle_ || handle_.done() )
+		return false;
+
+	handle_.resume();
+	return !handle_.done();
+}
+
+/******************************************************************************/
+/*!
+
+Returns the event the search is suspended at.
+
+\return
+The last event Next stopped at.
+
+*/
+/******************************************************************************/
+const TourGenerator::Event& TourGenerator::GetEvent(void) const
+{
+	return *handle_.promise().event;
+}
+
+/******************************************************************************/
+/*!
+
+Runs the search to its first event.
+
+\return
+An iterator at the first event, or end() if there is none.
+
+*/
+/******************************************************************************/
+TourGenerator::iterator TourGenerator::begin(void)
+{
+	return Next() ? iterator( this ) : iterator();
+}
+
+/******************************************************************************/
+/*!
+
+Returns the iterator past the last event.
+
+\return
+The end iterator.
+
+*/
+/******************************************************************************/
+TourGenerator::iterator TourGenerator::end(void)
+{
+	return iterator();
+}
@@ -0,0 +1,113 @@
+/******************************************************************************/
+/*!
+\file   TourGenerator.h
+\brief
+This is the declaration file for the class TourGenerator, a C++20 coroutine
+that hands out the tours of a GameBoard one at a time, as they are pulled.
+
+*/
+/******************************************************************************/
+
+//---------------------------------------------------------------------------
+#ifndef TOURGENERATORH
+#define TOURGENERATORH
+//---------------------------------------------------------------------------
+
+#include "GameBoard.h"
+#include <coroutine>
+#include <iterator>
+#include <utility>
+
+class TourGenerator
+{
+  public:
+    // One thing the search did.
+    struct Event
+    {
+      GameBoard::BoardMessage message; // MSG_FINISHED_OK for a tour, or MSG_PLACING/MSG_REMOVING
+      unsigned move;                   // the move number of the square
+      unsigned row;                    // the square placed, taken back, or the tour's last
+      unsigned column;
+    };
+
+    struct promise_type
+    {
+      const Event *event;
+
+      TourGenerator get_return_object(void)
+      {
+        return TourGenerator( std::coroutine_handle<promise_type>::from_promise( *this ) );
+      }
+      std::suspend_always initial_suspend(void) noexcept { return std::suspend_always(); }
+      std::suspend_always final_suspend(void) noexcept { return std::suspend_always(); }
+      std::suspend_always yield_value(const Event& yielded)
+      {
+        event = &yielded;
+        return std::suspend_always();
+      }
+      void return_void(void) {}
+      void unhandled_exception(void) { throw; }
+    };
+
+      // Searches board from row,column, suspended between pulls. Every tour
+      // is yielded as it is found, the board holding it (GetBoard) until the
+      // next pull, and the search then backs off and carries on to the next
+      // one, so no tour comes out twice. With moves, every square placed and
+      // taken back is yielded too. The board has to outlive the generator,
+      // and is left mid-search if the generator is dropped early.
+    static TourGenerator Tours(GameBoard& board, unsigned row, unsigned column,
+                               GameBoard::TourPolicy policy = GameBoard::tpHEURISTICS,
+                               bool moves = false);
+
+    TourGenerator(TourGenerator&& other);
+    TourGenerator& operator=(TourGenerator&& other);
+    ~TourGenerator();
+
+      // Runs the search to its next event. False once it has none left.
+    bool Next(void);
+      // The event Next stopped at.
+    const Event& GetEvent(void) const;
+
+      // Pulls the events one at a time: for (const Event& e : generator)
+    class iterator
+    {
+      public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef Event value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Event* pointer;
+        typedef const Event& reference;
+
+        iterator(void) : generator_(0) {}
+        explicit iterator(TourGenerator *generator) : generator_(generator) {}
+
+        const Event& operator*(void) const { return generator_->GetEvent(); }
+        const Event* operator->(void) const { return &generator_->GetEvent(); }
+        iterator& operator++(void)
+        {
+          if( !generator_->Next() )
+            generator_ = 0;
+          return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        bool operator==(const iterator& rhs) const { return generator_ == rhs.generator_; }
+        bool operator!=(const iterator& rhs) const { return generator_ != rhs.generator_; }
+
+      private:
+        TourGenerator *generator_;
+    };
+
+    iterator begin(void);
+    iterator end(void);
+
+  private:
+    std::coroutine_handle<promise_type> handle_;
+
+    explicit TourGenerator(std::coroutine_handle<promise_type> handle);
+
+    TourGenerator(const TourGenerator&);
+    TourGenerator& operator=(const TourGenerator&);
+};
+
+#endif  // TOURGENERATORH
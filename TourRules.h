@@ -0,0 +1,202 @@
+/******************************************************************************/
+/*!
+\file   TourRules.h
+\brief
+This is the declaration file for the rules GameBoard and HamiltonianSolver
+both search by: which candidates are dropped for stranding a square, which
+ones tie, and the order the rest are tried in.
+
+Each search keeps its own tables, so the rules read them through the
+functions they are handed, which are inlined into each search's loops.
+
+*/
+/******************************************************************************/
+
+//---------------------------------------------------------------------------
+#ifndef TOURRULESH
+#define TOURRULESH
+//---------------------------------------------------------------------------
+
+/******************************************************************************/
+/*!
+
+Drops the candidates that would leave some square with no way through, once
+the current square is taken. Every unvisited square needs two ways in and
+out, or one if the tour ends there:
+
+ - a candidate left with no onward moves has to be the very next move and
+   the last square, so anything else is a dead end.
+ - a candidate left with one onward move has to be moved to next, or else
+   the tour must end there. If more of these turn up than the one end the
+   tour has, nothing works; if exactly that many turn up, the next move has
+   to be one of them.
+
+Dropped candidates get their degree back, since the search only restores
+the ones it tries. Either way the square the search is on stays taken, so
+the degrees read further on can be too high. That only hides dead ends; it
+never drops a move that leads to a tour.
+
+\param candidates
+The candidates, their degrees already taken one from. Kept candidates are
+moved to the front.
+
+\param count
+The number of candidates.
+
+\param remaining
+The squares still to be placed after the current one.
+
+\param end
+The square the tour has to end on, or ~0u for any.
+
+\param degree
+degree(v) gives v's onward moves.
+
+\param restore
+restore(v) gives v back the move taken from its degree.
+
+\param forced
+Receives the candidates left with one onward move.
+
+\param forcedCount
+Receives the number of those candidates.
+
+\return
+The number of candidates kept.
+
+*/
+/******************************************************************************/
+template< class Degree, class Restore >
+unsigned PruneDeadEnds( unsigned* candidates, const unsigned& count, const unsigned& remaining, const unsigned& end,
+                        Degree degree, Restore restore, unsigned* forced, unsigned& forcedCount )
+{
+	const unsigned ends = end == ~0u ? 2 : 1;
+
+	unsigned isolated = 0;
+	unsigned ones = 0;
+
+	for( unsigned i=0; i<count; i++ )
+	{
+		const unsigned moves = degree( candidates[i] );
+
+		if( moves == 0 )
+			++isolated;
+		else if( moves == 1 && candidates[i] != end )
+			++ones;
+	}
+
+	const bool dead = ( isolated && remaining > 1 ) || ones > ends;
+	const bool restrict = ones == ends;
+
+	forcedCount = 0;
+	unsigned kept = 0;
+
+	for( unsigned i=0; i<count; i++ )
+	{
+		const bool isForced = degree( candidates[i] ) == 1 && candidates[i] != end;
+
+		if( dead || ( restrict && !isForced ) )
+		{
+			restore( candidates[i] );
+			continue;
+		}
+
+		if( isForced )
+			forced[forcedCount++] = candidates[i];
+
+		candidates[kept++] = candidates[i];
+	}
+
+	return kept;
+}
+
+/******************************************************************************/
+/*!
+
+Visits the candidates that tie with another on both degree and rank. Only
+those need Pohl's second-level sums worked out.
+
+\param candidates
+The candidates.
+
+\param count
+The number of candidates.
+
+\param degree
+degree(v) gives v's onward moves.
+
+\param rank
+rank(v) gives v's rank.
+
+\param tie
+tie(v) is called once for each candidate that ties.
+
+*/
+/******************************************************************************/
+template< class Degree, class Rank, class Tie >
+void ForEachTie( unsigned const* candidates, const unsigned& count, Degree degree, Rank rank, Tie tie )
+{
+	for( unsigned i=0; i<count; i++ )
+	{
+		for( unsigned j=0; j<count; j++ )
+		{
+			if( j != i && degree( candidates[i] ) == degree( candidates[j] ) && rank( candidates[i] ) == rank( candidates[j] ) )
+			{
+				tie( candidates[i] );
+				break;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Orders two candidates by Warnsdorff's rule: fewer onward moves first, then
+the higher rank (for a board, the square farther from the center), then
+(for a search using them) the lower of Pohl's second-level sums, then
+whatever the search breaks the rest of its ties with.
+
+\param leftDegree
+The onward moves of one candidate.
+
+\param leftRank
+Its rank.
+
+\param rightDegree
+The onward moves of the other candidate.
+
+\param rightRank
+Its rank.
+
+\param lookahead
+lookahead() orders the two by their second-level sums when the degrees
+and ranks tie, negative for the first, positive for the second, or 0.
+
+\param tieBreak
+tieBreak() orders the two when all of those tie, the same way.
+
+\return
+Negative when the first candidate goes first, positive when the second
+does, and 0 when they tie.
+
+*/
+/******************************************************************************/
+template< class Lookahead, class TieBreak >
+int CompareCandidates( const unsigned& leftDegree, const unsigned& leftRank, const unsigned& rightDegree,
+                       const unsigned& rightRank, Lookahead lookahead, TieBreak tieBreak )
+{
+	if( leftDegree != rightDegree )
+		return leftDegree < rightDegree ? -1 : 1;
+
+	if( leftRank != rightRank )
+		return leftRank > rightRank ? -1 : 1;
+
+	const int sums = lookahead();
+	if( sums )
+		return sums;
+
+	return tieBreak();
+}
+
+#endif  // TOURRULESH
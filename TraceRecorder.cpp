@@ -0,0 +1,260 @@
+/******************************************************************************/
+/*!
+\file   TraceRecorder.cpp
+\brief
+This is the implementation file for the class TraceRecorder.
+
+The search and the writer share a ring of events with one index each: the
+search only moves head_ and the writer only moves tail_, so neither takes a
+lock. Recording an event is a store into the ring and a release of head_;
+the file is written by the other thread, a stretch of the ring at a time.
+
+*/
+/******************************************************************************/
+
+#include "TraceRecorder.h"
+#include <string.h>
+#include <chrono>
+
+//Identifies a trace file, and the layout of its events.
+const char traceMagic[4] = { 'K', 'T', 'T', 'R' };
+const unsigned traceVersion = 1;
+//The smallest ring handed out.
+const unsigned minCapacity = 1 << 10;
+//The writer only yields the first times it finds the ring empty, and sleeps
+//once it has stayed empty, so a small ring isn't left full for a whole sleep.
+const unsigned writerSpins = 1 << 10;
+const std::chrono::milliseconds writerIdle( 1 );
+
+static_assert( sizeof(TraceRecorder::Event) == 8, "trace events are written as 8 bytes" );
+
+/******************************************************************************/
+/*!
+
+Opens the trace file, writes its header, and starts the writer. A board
+with more squares than an event can tell apart isn't opened at all, rather
+than traced with its squares cut short.
+
+\param path
+The file to write.
+
+\param rows
+The number of rows in the board.
+
+\param columns
+The number of columns in the board.
+
+\param capacity
+The events the ring holds, rounded up to a power of two.
+
+*/
+/******************************************************************************/
+TraceRecorder::TraceRecorder(const char *path, unsigned rows, unsigned columns, unsigned capacity)
+:	file_(static_cast<unsigned long long>(rows) * columns <= maxSquares ? fopen( path, "wb" ) : 0), columns_(columns), mask_(0), head_(0), tailSeen_(0), stalls_(0),
+	tail_(0), stopping_(false)
+{
+	unsigned long long size = minCapacity;
+	while( size < capacity )
+		size <<= 1;
+
+	ring_.resize( size );
+	mask_ = size - 1;
+
+	if( file_ )
+	{
+		Header header;
+		memcpy( header.magic, traceMagic, sizeof(traceMagic) );
+		header.version = traceVersion;
+		header.rows = rows;
+		header.columns = columns;
+		fwrite( &header, sizeof(header), 1, file_ );
+
+		writer_ = std::thread( &TraceRecorder::drain, this );
+	}
+}
+
+/******************************************************************************/
+/*!
+
+Stops the writer once it has written out the ring, and closes the file.
+
+*/
+/******************************************************************************/
+TraceRecorder::~TraceRecorder()
+{
+	stopping_.store( true, std::memory_order_release );
+
+	if( writer_.joinable() )
+		writer_.join();
+
+	if( file_ )
+		fclose( file_ );
+}
+
+/******************************************************************************/
+/*!
+
+Checks if the trace file was opened.
+
+\return
+If events are being written.
+
+*/
+/******************************************************************************/
+bool TraceRecorder::IsOpen(void) const
+{
+	return file_ != 0;
+}
+
+/******************************************************************************/
+/*!
+
+Returns the events recorded so far.
+
+\return
+The number of events.
+
+*/
+/******************************************************************************/
+unsigned long long TraceRecorder::GetEvents(void) const
+{
+	return head_.load( std::memory_order_relaxed );
+}
+
+/******************************************************************************/
+/*!
+
+Returns the times Record found the ring full and had to wait for the
+writer. Many stalls mean the ring is too small for the disk.
+
+\return
+The number of stalls.
+
+*/
+/******************************************************************************/
+unsigned long long TraceRecorder::GetStalls(void) const
+{
+	return stalls_;
+}
+
+/******************************************************************************/
+/*!
+
+Reads and checks the header of a trace file.
+
+\param file
+The trace, at its start. Left at its first event.
+
+\param rows
+Set to the number of rows in the board.
+
+\param columns
+Set to the number of columns in the board.
+
+\return
+False if the file isn't a trace this version can read, or its board is
+too big to have been traced.
+
+*/
+/******************************************************************************/
+bool TraceRecorder::ReadHeader(FILE *file, unsigned& rows, unsigned& columns)
+{
+	Header header;
+	if( fread( &header, sizeof(header), 1, file ) != 1 )
+		return false;
+
+	if( memcmp( header.magic, traceMagic, sizeof(traceMagic) ) || header.version != traceVersion )
+		return false;
+
+	if( static_cast<unsigned long long>(header.rows) * header.columns > maxSquares )
+		return false;
+
+	rows = header.rows;
+	columns = header.columns;
+	return true;
+}
+
+/******************************************************************************/
+/*!
+
+Waits until the writer has emptied the slot the search is about to fill.
+Only reached when the ring is full, so Record reads tail_ just this once
+per lap of the ring. With no file there is no writer, and the ring is
+simply written over.
+
+\param head
+The slot about to be filled.
+
+*/
+/******************************************************************************/
+void TraceRecorder::waitForRoom(unsigned long long head)
+{
+	if( !file_ )
+	{
+		tailSeen_ = head;
+		return;
+	}
+
+	tailSeen_ = tail_.load( std::memory_order_acquire );
+	if( head - tailSeen_ <= mask_ )
+		return;
+
+	++stalls_;
+	do
+	{
+		std::this_thread::yield();
+		tailSeen_ = tail_.load( std::memory_order_acquire );
+	} while( head - tailSeen_ > mask_ );
+}
+
+/******************************************************************************/
+/*!
+
+Writes out the events between tail_ and head_ as they arrive, waiting
+while there are none, until the recorder is stopped and the ring is empty.
+
+*/
+/******************************************************************************/
+void TraceRecorder::drain(void)
+{
+	unsigned long long tail = tail_.load( std::memory_order_relaxed );
+	unsigned idle = 0;
+
+	for( ;; )
+	{
+		//stopping is read first, so the head read after it holds every event.
+		const bool stopping = stopping_.load( std::memory_order_acquire );
+		const unsigned long long head = head_.load( std::memory_order_acquire );
+
+		if( head == tail )
+		{
+			if( stopping )
+				break;
+
+			if( ++idle < writerSpins )
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for( writerIdle );
+			continue;
+		}
+
+		idle = 0;
+
+		//the events can wrap past the end of the ring, so write them in two
+		//stretches at most.
+		while( tail != head )
+		{
+			const unsigned long long first = tail & mask_;
+			unsigned long long count = head - tail;
+			if( count > ring_.size() - first )
+				count = ring_.size() - first;
+
+			fwrite( &ring_[first], sizeof(Event), count, file_ );
+
+			tail += count;
+			tail_.store( tail, std::memory_order_release );
+		}
+	}
+
+	fflush( file_ );
+}
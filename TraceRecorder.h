@@ -0,0 +1,109 @@
+/******************************************************************************/
+/*!
+\file   TraceRecorder.h
+\brief
+This is the declaration file for the class TraceRecorder, which records the
+events of a search to a file from a background thread.
+
+*/
+/******************************************************************************/
+
+//---------------------------------------------------------------------------
+#ifndef TRACERECORDERH
+#define TRACERECORDERH
+//---------------------------------------------------------------------------
+
+#include "GameBoard.h"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class TraceRecorder
+{
+  public:
+    // One event, as it is kept in the buffer and in the file.
+    struct Event
+    {
+      unsigned move;        // the moves made so far (the callback's move)
+      unsigned cell : 28;   // row * columns + column, below maxSquares
+      unsigned message : 4; // a GameBoard::BoardMessage
+    };
+
+    // The start of a trace file, followed by its events.
+    struct Header
+    {
+      char magic[4];        // "KTTR"
+      unsigned version;
+      unsigned rows;
+      unsigned columns;
+    };
+
+      // Boards with more squares than this can't be traced, as an event
+      // keeps its square in 28 bits.
+    static const unsigned long long maxSquares = 1ULL << 28;
+
+      // Opens path for a board of rows x columns and starts the thread that
+      // writes to it. capacity events are buffered, rounded up to a power of
+      // two. Boards over maxSquares aren't opened.
+    TraceRecorder(const char *path, unsigned rows, unsigned columns, unsigned capacity = 1 << 20);
+      // Writes out every event still buffered and stops the thread.
+    ~TraceRecorder();
+
+      // False if the file couldn't be opened, or the board is too big. Nothing
+      // is recorded then.
+    bool IsOpen(void) const;
+
+      // Queues one event. Only one thread may record, the one running the
+      // search. When the buffer is full it waits for the writer, so no event
+      // is ever dropped.
+    void Record(GameBoard::BoardMessage message, unsigned move, unsigned row, unsigned column)
+    {
+      const unsigned long long head = head_.load( std::memory_order_relaxed );
+      if( head - tailSeen_ > mask_ )
+        waitForRoom( head );
+
+      Event& event = ring_[ head & mask_ ];
+      event.move = move;
+      event.cell = row * columns_ + column;
+      event.message = message;
+
+      head_.store( head + 1, std::memory_order_release );
+    }
+
+      // The events recorded so far, and the times Record had to wait.
+    unsigned long long GetEvents(void) const;
+    unsigned long long GetStalls(void) const;
+
+      // Reads the header of a trace file, leaving file at its first event.
+      // False if it isn't a trace.
+    static bool ReadHeader(FILE *file, unsigned& rows, unsigned& columns);
+
+  private:
+    FILE *file_;
+    unsigned columns_;
+    std::vector<Event> ring_;
+    unsigned long long mask_;
+
+    //the search's end of the ring: the next slot it fills, the writer's
+    //position when it last looked, and the times it waited.
+    alignas(64) std::atomic<unsigned long long> head_;
+    unsigned long long tailSeen_;
+    unsigned long long stalls_;
+
+    //the writer's end: the next slot it empties.
+    alignas(64) std::atomic<unsigned long long> tail_;
+    std::atomic<bool> stopping_;
+    std::thread writer_;
+
+    //waits until the writer has emptied the slot at head.
+    void waitForRoom(unsigned long long head);
+
+    //the writer thread: writes out events until stopped and drained.
+    void drain(void);
+
+    TraceRecorder(const TraceRecorder&);
+    TraceRecorder& operator=(const TraceRecorder&);
+};
+
+#endif  // TRACERECORDERH
@@ -0,0 +1,696 @@
+/******************************************************************************/
+/*!
+\file   benchmark.cpp
+\brief
+Timing and backtracking sweeps for the GameBoard tour policies.
+
+Usage:
+  benchmark boards [low] [high] [policy]
+  benchmark lookahead [low] [high] [step] [stride]
+  benchmark restarts [low] [high] [step] [stride] [seed] [threads]
+  benchmark count [rows] [columns] [closed] [threads] [checkpoint]
+  benchmark layout [rows] [columns] [policy]
+  benchmark pages [rows] [columns] [policy]
+  benchmark render [rows] [columns]
+  benchmark graph [rows] [columns] [policy]
+  benchmark repair [rows] [columns]
+  benchmark endgame [low] [high] [step] [stride] [squares]
+
+Every board from low x low up to high x high (and the low x low+1
+rectangles alongside them) is toured from every start square whose row and
+column are multiples of stride. A stride of 0 picks one that keeps each
+board to roughly 400 starts; a stride of 1 visits every start square.
+
+The boards sweep is the driver's TestBoards without the printing: every
+board from low x low up to high x high, toured from its corner. It is the
+workload the profile-guided build is trained on.
+
+The lookahead sweep compares tpHEURISTICS with tpLOOKAHEAD over the same
+boards and starts. Over 5..200 step 15, tpLOOKAHEAD backtracks about a
+fifth as much as tpHEURISTICS in about the same time. It finds two fewer
+tours, both from 5x6 starts that run out of moves.
+
+The restarts sweep compares the move-count and time percentiles of single
+tpHEURISTICS searches against KnightsTourRestarts, over the starts
+IsTourPossible allows.
+
+The endgame sweep compares tpHEURISTICS with and without its last squares
+finished exactly (SetEndgame), over the same boards and starts.
+
+The count mode times TourCounter over every start of one board. With a
+checkpoint file, a count that is stopped picks up where it left off.
+
+The layout mode tours one large board from its corner once for each
+BoardLayout, and reports the time and the cache misses per move. Misses are
+read from the hardware counters (Linux perf events), and show as n/a where
+those can't be opened.
+
+The pages mode does the same with the tables on ordinary and on huge pages,
+and reports the page faults taken building and touring each board, and the
+data TLB misses per move.
+
+The render mode times printing one tour in each BoardRenderer style to a
+scratch file, against printf called for every square.
+
+The graph mode tours one board from its corner with KnightsTour, and again
+with HamiltonianSolver over a KnightGraph of the same board, and checks
+that both found the same tour.
+
+The repair mode tours one board from its corner, then changes it three ways:
+two squares next to each other in the middle of the tour blocked, the start
+moved a few moves along it, and the end required a few moves before its
+own. Each change is repaired with KnightsTourRepair, and where KnightsTour
+can take the same change, it is timed searching again from scratch.
+
+*/
+/******************************************************************************/
+
+#include "GameBoard.h"
+#include "TourCounter.h"
+#include "BoardRenderer.h"
+#include "HamiltonianSolver.h"
+#include "KnightGraph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Runs are abandoned once they have made this many moves per square.
+	const unsigned BUDGET_PER_SQUARE = 20;
+
+	unsigned budget = 0;
+
+	// Tallies one policy over a sweep.
+	struct Tally
+	{
+		unsigned tours;
+		unsigned failures;
+		unsigned long long backtracks;
+		double ms;
+
+		Tally( void ) : tours(0), failures(0), backtracks(0), ms(0) {}
+	};
+}
+
+// Wall-clock milliseconds, so that raced threads are not counted twice.
+double Milliseconds(void)
+{
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Callback(const GameBoard&, const int *, GameBoard::BoardMessage message, unsigned move, unsigned, unsigned, unsigned, unsigned)
+{
+	if (message == GameBoard::MSG_ABORT_CHECK)
+		return move > budget;
+
+	return false;
+}
+
+void TourBoard(unsigned rows, unsigned columns, unsigned stride, GameBoard::TourPolicy policy, Tally& tally,
+	unsigned endgame = 0)
+{
+	GameBoard gb(rows, columns, Callback);
+	gb.SetEndgame(endgame);
+	budget = BUDGET_PER_SQUARE * rows * columns;
+
+	for (unsigned r = 0; r < rows; r += stride)
+	{
+		for (unsigned c = 0; c < columns; c += stride)
+		{
+			double start = Milliseconds();
+			bool tour = gb.KnightsTour(r, c, policy);
+			tally.ms += Milliseconds() - start;
+
+			if (tour)
+			{
+				++tally.tours;
+				tally.backtracks += gb.GetMoves() - rows * columns;
+			}
+			else
+			{
+				++tally.failures;
+				tally.backtracks += gb.GetMoves();
+			}
+		}
+	}
+}
+
+void PrintTally(const char *name, const Tally& tally)
+{
+	printf("  %-10s tours %6u  failed %6u  backtracks %12llu  %8.1f ms\n",
+		name, tally.tours, tally.failures, tally.backtracks, tally.ms);
+}
+
+void BenchBoards(unsigned low, unsigned high, GameBoard::TourPolicy policy)
+{
+	Tally total;
+
+	for (unsigned i = low; i <= high; i++)
+	{
+		//a stride of the whole board tours the corner alone.
+		Tally tally;
+		TourBoard(i, i, i, policy, tally);
+
+		total.tours += tally.tours;
+		total.failures += tally.failures;
+		total.backtracks += tally.backtracks;
+		total.ms += tally.ms;
+	}
+
+	printf("Boards %ux%u to %ux%u, from the corner\n", low, low, high, high);
+	PrintTally(policy == GameBoard::tpSTATIC ? "STATIC" : policy == GameBoard::tpHEURISTICS ? "HEURISTICS" : "LOOKAHEAD", total);
+}
+
+void BenchLookahead(unsigned low, unsigned high, unsigned step, unsigned stride)
+{
+	Tally heuristicsTotal;
+	Tally lookaheadTotal;
+
+	for (unsigned i = low; i <= high; i += step)
+	{
+		for (unsigned j = i; j <= i + 1; j++)
+		{
+			unsigned s = stride;
+			if (!s)
+				s = (i * j) / 400 + 1;
+
+			Tally heuristics;
+			Tally lookahead;
+			TourBoard(i, j, s, GameBoard::tpHEURISTICS, heuristics);
+			TourBoard(i, j, s, GameBoard::tpLOOKAHEAD, lookahead);
+
+			printf("Board %ux%u, start stride %u\n", i, j, s);
+			PrintTally("HEURISTICS", heuristics);
+			PrintTally("LOOKAHEAD", lookahead);
+
+			heuristicsTotal.tours += heuristics.tours;
+			heuristicsTotal.failures += heuristics.failures;
+			heuristicsTotal.backtracks += heuristics.backtracks;
+			heuristicsTotal.ms += heuristics.ms;
+			lookaheadTotal.tours += lookahead.tours;
+			lookaheadTotal.failures += lookahead.failures;
+			lookaheadTotal.backtracks += lookahead.backtracks;
+			lookaheadTotal.ms += lookahead.ms;
+		}
+	}
+
+	printf("Total\n");
+	PrintTally("HEURISTICS", heuristicsTotal);
+	PrintTally("LOOKAHEAD", lookaheadTotal);
+}
+
+void BenchEndgame(unsigned low, unsigned high, unsigned step, unsigned stride, unsigned squares)
+{
+	Tally plainTotal;
+	Tally endgameTotal;
+
+	for (unsigned i = low; i <= high; i += step)
+	{
+		for (unsigned j = i; j <= i + 1; j++)
+		{
+			unsigned s = stride;
+			if (!s)
+				s = (i * j) / 400 + 1;
+
+			Tally plain;
+			Tally endgame;
+			TourBoard(i, j, s, GameBoard::tpHEURISTICS, plain);
+			TourBoard(i, j, s, GameBoard::tpHEURISTICS, endgame, squares);
+
+			printf("Board %ux%u, start stride %u\n", i, j, s);
+			PrintTally("HEURISTICS", plain);
+			PrintTally("ENDGAME", endgame);
+
+			plainTotal.tours += plain.tours;
+			plainTotal.failures += plain.failures;
+			plainTotal.backtracks += plain.backtracks;
+			plainTotal.ms += plain.ms;
+			endgameTotal.tours += endgame.tours;
+			endgameTotal.failures += endgame.failures;
+			endgameTotal.backtracks += endgame.backtracks;
+			endgameTotal.ms += endgame.ms;
+		}
+	}
+
+	printf("Total\n");
+	PrintTally("HEURISTICS", plainTotal);
+	PrintTally("ENDGAME", endgameTotal);
+}
+
+void PrintPercentiles(const char *name, std::vector<double>& samples, const char *unit)
+{
+	std::sort(samples.begin(), samples.end());
+	size_t count = samples.size();
+
+	printf("  %-10s p50 %12.2f  p90 %12.2f  p99 %12.2f  max %12.2f %s\n", name,
+		samples[count / 2], samples[(count * 9) / 10], samples[(count * 99) / 100],
+		samples[count - 1], unit);
+}
+
+void BenchRestarts(unsigned low, unsigned high, unsigned step, unsigned stride, unsigned seed, unsigned threads)
+{
+	std::vector<double> singleMoves, singleTimes;
+	std::vector<double> restartMoves, restartTimes;
+	unsigned singleTours = 0;
+	unsigned restartTours = 0;
+
+	for (unsigned i = low; i <= high; i += step)
+	{
+		for (unsigned j = i; j <= i + 1; j++)
+		{
+			unsigned s = stride;
+			if (!s)
+				s = (i * j) / 400 + 1;
+
+			GameBoard gb(i, j, Callback);
+			budget = BUDGET_PER_SQUARE * i * j;
+
+			for (unsigned r = 0; r < i; r += s)
+			{
+				for (unsigned c = 0; c < j; c += s)
+				{
+					// Only time the starts that can have a tour.
+					if (!GameBoard::IsTourPossible(i, j, r, c))
+						continue;
+
+					double start = Milliseconds();
+					singleTours += gb.KnightsTour(r, c, GameBoard::tpHEURISTICS);
+					singleTimes.push_back(Milliseconds() - start);
+					singleMoves.push_back(gb.GetMoves());
+
+					start = Milliseconds();
+					restartTours += gb.KnightsTourRestarts(r, c, GameBoard::tpHEURISTICS, seed, threads);
+					restartTimes.push_back(Milliseconds() - start);
+					restartMoves.push_back(gb.GetMoves());
+				}
+			}
+		}
+	}
+
+	printf("%u runs, %u tours single, %u tours restarted (seed %u, %u threads)\n",
+		static_cast<unsigned>(singleMoves.size()), singleTours, restartTours, seed, threads);
+	PrintPercentiles("SINGLE", singleMoves, "moves");
+	PrintPercentiles("RESTARTS", restartMoves, "moves");
+	PrintPercentiles("SINGLE", singleTimes, "ms");
+	PrintPercentiles("RESTARTS", restartTimes, "ms");
+}
+
+void BenchCount(unsigned rows, unsigned columns, bool closed, unsigned threads, const char *checkpoint)
+{
+	GameBoard gb(rows, columns);
+	TourCounter counter(gb, closed, threads);
+	counter.SetCheckpoint(checkpoint);
+
+	std::vector<unsigned long long> counts(rows * columns);
+	double start = Milliseconds();
+	unsigned long long total = counter.CountAll(&counts[0]);
+
+	printf("Board %ux%u, %s tours %llu in %.1f ms\n", rows, columns,
+		closed ? "closed" : "open", total, Milliseconds() - start);
+	if (checkpoint)
+		printf("  %u jobs resumed from %s\n", counter.GetResumed(), checkpoint);
+}
+
+// The events the benchmarks count.
+enum PerfEvent
+{
+	peCACHE_MISSES,
+	peTLB_MISSES,
+	pePAGE_FAULTS
+};
+
+// Counts an event on this thread between Start and Stop. Page faults are a
+// software event, so they can be counted where the hardware ones can't, and
+// include the threads started meanwhile.
+class PerfCounter
+{
+public:
+	PerfCounter(PerfEvent event) : fd_(-1)
+	{
+#ifdef __linux__
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		if (event == peCACHE_MISSES)
+		{
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		}
+		else if (event == peTLB_MISSES)
+		{
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+				(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		}
+		else
+		{
+			attr.type = PERF_TYPE_SOFTWARE;
+			attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+			attr.inherit = 1;
+		}
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+		(void)event;
+#endif
+	}
+
+	~PerfCounter(void)
+	{
+#ifdef __linux__
+		if (fd_ >= 0)
+			close(fd_);
+#endif
+	}
+
+	bool IsOpen(void) const
+	{
+		return fd_ >= 0;
+	}
+
+	void Start(void)
+	{
+#ifdef __linux__
+		if (fd_ >= 0)
+		{
+			ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	unsigned long long Stop(void)
+	{
+		unsigned long long count = 0;
+#ifdef __linux__
+		if (fd_ >= 0)
+		{
+			ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(fd_, &count, sizeof(count)) != sizeof(count))
+				count = 0;
+		}
+#endif
+		return count;
+	}
+
+private:
+	int fd_;
+};
+
+void BenchLayout(unsigned rows, unsigned columns, GameBoard::TourPolicy policy)
+{
+	const char *names[] = { "ROWS", "TILES", "MORTON" };
+	const GameBoard::BoardLayout layouts[] = { GameBoard::blROWS, GameBoard::blTILES, GameBoard::blMORTON };
+
+	PerfCounter misses(peCACHE_MISSES);
+	printf("Board %ux%u from 0,0\n", rows, columns);
+
+	for (unsigned i = 0; i < 3; i++)
+	{
+		double start = Milliseconds();
+		GameBoard gb(rows, columns, Callback, 0, 1, 2, layouts[i]);
+		double built = Milliseconds() - start;
+		budget = BUDGET_PER_SQUARE * rows * columns;
+
+		misses.Start();
+		start = Milliseconds();
+		bool tour = gb.KnightsTour(0, 0, policy);
+		double ms = Milliseconds() - start;
+		unsigned long long count = misses.Stop();
+
+		printf("  %-10s %s  moves %10u  build %8.1f ms  tour %8.1f ms", names[i],
+			tour ? "tour  " : "failed", gb.GetMoves(), built, ms);
+		if (misses.IsOpen() && gb.GetMoves())
+			printf("  misses/move %6.2f\n", static_cast<double>(count) / gb.GetMoves());
+		else
+			printf("  misses/move    n/a\n");
+	}
+}
+
+void BenchPages(unsigned rows, unsigned columns, GameBoard::TourPolicy policy)
+{
+	const char *names[] = { "SMALL", "HUGE" };
+
+	PerfCounter misses(peTLB_MISSES);
+	PerfCounter faults(pePAGE_FAULTS);
+	printf("Board %ux%u from 0,0\n", rows, columns);
+
+	for (unsigned i = 0; i < 2; i++)
+	{
+		faults.Start();
+		double start = Milliseconds();
+		GameBoard gb(rows, columns, Callback, 0, 1, 2, GameBoard::blROWS, i != 0);
+		double built = Milliseconds() - start;
+		budget = BUDGET_PER_SQUARE * rows * columns;
+
+		misses.Start();
+		start = Milliseconds();
+		bool tour = gb.KnightsTour(0, 0, policy);
+		double ms = Milliseconds() - start;
+		unsigned long long count = misses.Stop();
+		unsigned long long faulted = faults.Stop();
+
+		printf("  %-10s %s  moves %10u  build %8.1f ms  tour %8.1f ms", names[i],
+			tour ? "tour  " : "failed", gb.GetMoves(), built, ms);
+		if (faults.IsOpen())
+			printf("  page faults %8llu", faulted);
+		if (misses.IsOpen() && gb.GetMoves())
+			printf("  TLB misses/move %6.2f\n", static_cast<double>(count) / gb.GetMoves());
+		else
+			printf("  TLB misses/move    n/a\n");
+	}
+}
+
+void BenchRender(unsigned rows, unsigned columns)
+{
+	GameBoard gb(rows, columns);
+	bool tour = gb.KnightsTour(0, 0, GameBoard::tpHEURISTICS);
+	printf("Board %ux%u, %s\n", rows, columns, tour ? "toured" : "no tour");
+
+	FILE *file = tmpfile();
+	if (!file)
+	{
+		printf("  no scratch file\n");
+		return;
+	}
+
+	const int *board = gb.GetBoard();
+
+	double start = Milliseconds();
+	for (unsigned r = 0; r < rows; r++)
+	{
+		for (unsigned c = 0; c < columns; c++)
+			fprintf(file, "%6i", board[r * columns + c]);
+		fprintf(file, "\n");
+	}
+	fflush(file);
+	printf("  %-10s %8.1f ms  %10ld bytes\n", "PRINTF", Milliseconds() - start, ftell(file));
+
+	const char *names[] = { "BOXED", "FLAT", "CSV" };
+	const BoardRenderer::RenderStyle styles[] = { BoardRenderer::rsBOXED, BoardRenderer::rsFLAT, BoardRenderer::rsCSV };
+
+	for (unsigned i = 0; i < 3; i++)
+	{
+		rewind(file);
+		BoardRenderer renderer(file);
+
+		start = Milliseconds();
+		renderer.Render(board, rows, columns, styles[i]);
+		fflush(file);
+		printf("  %-10s %8.1f ms  %10ld bytes\n", names[i], Milliseconds() - start, ftell(file));
+	}
+
+	fclose(file);
+}
+
+void BenchGraph(unsigned rows, unsigned columns, GameBoard::TourPolicy policy)
+{
+	printf("Board %ux%u from 0,0\n", rows, columns);
+	budget = BUDGET_PER_SQUARE * rows * columns;
+
+	GameBoard gb(rows, columns, Callback);
+	double start = Milliseconds();
+	bool tour = gb.KnightsTour(0, 0, policy);
+	double ms = Milliseconds() - start;
+	printf("  %-10s %s  moves %10u  tour %8.1f ms\n", "GAMEBOARD", tour ? "tour  " : "failed", gb.GetMoves(), ms);
+
+	const HamiltonianSolver<KnightGraph>::Ordering orderings[] =
+		{ HamiltonianSolver<KnightGraph>::hoNONE, HamiltonianSolver<KnightGraph>::hoDEGREE,
+		  HamiltonianSolver<KnightGraph>::hoLOOKAHEAD };
+
+	KnightGraph graph(gb);
+	HamiltonianSolver<KnightGraph> solver(graph);
+	//the callback stops a search once it is past the budget.
+	start = Milliseconds();
+	tour = GameBoard::IsTourPossible(rows, columns, 0, 0) &&
+		solver.Solve(graph.GetVertex(0, 0), orderings[policy], budget + 1);
+	ms = Milliseconds() - start;
+	printf("  %-10s %s  moves %10llu  tour %8.1f ms", "GRAPH", tour ? "tour  " : "failed", solver.GetMoves(), ms);
+
+	std::vector<int> board(rows * columns);
+	graph.GetBoard(solver.GetPath(), &board[0]);
+	printf("  %s\n", memcmp(&board[0], gb.GetBoard(), board.size() * sizeof(int)) ? "different" : "same tour");
+}
+
+void BenchRepair(unsigned rows, unsigned columns)
+{
+	const unsigned squares = rows * columns;
+	printf("Board %ux%u from 0,0\n", rows, columns);
+	budget = BUDGET_PER_SQUARE * squares;
+
+	GameBoard gb(rows, columns, Callback);
+	double start = Milliseconds();
+	bool tour = gb.KnightsTour(0, 0, GameBoard::tpHEURISTICS);
+	printf("  %-10s %s  moves %10u  tour %8.1f ms\n", "TOUR", tour ? "tour  " : "failed", gb.GetMoves(),
+		Milliseconds() - start);
+	if (!tour || squares < 64)
+		return;
+
+	std::vector<int> old(gb.GetBoard(), gb.GetBoard() + squares);
+	std::vector<unsigned> at(squares + 1);
+	for (unsigned i = 0; i < squares; i++)
+		at[old[i]] = i;
+
+	bool *mask = new bool[squares];
+	for (unsigned i = 0; i < squares; i++)
+		mask[i] = true;
+	mask[at[squares / 2]] = false;
+	mask[at[squares / 2 + 1]] = false;
+
+	const char *names[] = { "BLOCKED", "START", "END" };
+	for (unsigned i = 0; i < 3; i++)
+	{
+		const unsigned row = i == 1 ? at[7] / columns : 0;
+		const unsigned column = i == 1 ? at[7] % columns : 0;
+		const unsigned end = i == 2 ? at[squares - 10] : ~0u;
+
+		GameBoard repair(rows, columns, 0, i == 0 ? mask : 0);
+		start = Milliseconds();
+		tour = repair.KnightsTourRepair(&old[0], row, column,
+			end == ~0u ? ~0u : end / columns, end == ~0u ? ~0u : end % columns);
+		printf("  %-10s %s  moves %10u  repair %8.1f ms", names[i], tour ? "tour  " : "failed", repair.GetMoves(),
+			Milliseconds() - start);
+
+		//KnightsTour can't be given an end.
+		if (i == 2)
+		{
+			printf("\n");
+			continue;
+		}
+
+		GameBoard again(rows, columns, Callback, i == 0 ? mask : 0);
+		start = Milliseconds();
+		tour = again.KnightsTour(row, column, GameBoard::tpHEURISTICS);
+		printf("  search %s %8.1f ms\n", tour ? "tour  " : "failed", Milliseconds() - start);
+	}
+
+	delete [] mask;
+}
+
+unsigned Argument(int argc, char **argv, int index, unsigned fallback)
+{
+	if (argc > index)
+		return static_cast<unsigned>(atoi(argv[index]));
+	return fallback;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "boards"))
+	{
+		BenchBoards(Argument(argc, argv, 2, 5), Argument(argc, argv, 3, 100),
+			static_cast<GameBoard::TourPolicy>(Argument(argc, argv, 4, GameBoard::tpHEURISTICS)));
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "lookahead"))
+	{
+		BenchLookahead(Argument(argc, argv, 2, 5), Argument(argc, argv, 3, 200),
+			Argument(argc, argv, 4, 15), Argument(argc, argv, 5, 0));
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "restarts"))
+	{
+		BenchRestarts(Argument(argc, argv, 2, 5), Argument(argc, argv, 3, 200),
+			Argument(argc, argv, 4, 15), Argument(argc, argv, 5, 0),
+			Argument(argc, argv, 6, 1), Argument(argc, argv, 7, 1));
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "endgame"))
+	{
+		BenchEndgame(Argument(argc, argv, 2, 5), Argument(argc, argv, 3, 200),
+			Argument(argc, argv, 4, 15), Argument(argc, argv, 5, 0),
+			Argument(argc, argv, 6, 16));
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "count"))
+	{
+		BenchCount(Argument(argc, argv, 2, 6), Argument(argc, argv, 3, 6),
+			Argument(argc, argv, 4, 0) != 0, Argument(argc, argv, 5, 0),
+			argc > 6 ? argv[6] : 0);
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "layout"))
+	{
+		BenchLayout(Argument(argc, argv, 2, 2000), Argument(argc, argv, 3, 2000),
+			static_cast<GameBoard::TourPolicy>(Argument(argc, argv, 4, GameBoard::tpHEURISTICS)));
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "pages"))
+	{
+		BenchPages(Argument(argc, argv, 2, 2000), Argument(argc, argv, 3, 2000),
+			static_cast<GameBoard::TourPolicy>(Argument(argc, argv, 4, GameBoard::tpHEURISTICS)));
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "render"))
+	{
+		BenchRender(Argument(argc, argv, 2, 1000), Argument(argc, argv, 3, 1000));
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "graph"))
+	{
+		BenchGraph(Argument(argc, argv, 2, 1000), Argument(argc, argv, 3, 1000),
+			static_cast<GameBoard::TourPolicy>(Argument(argc, argv, 4, GameBoard::tpHEURISTICS)));
+		return 0;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "repair"))
+	{
+		BenchRepair(Argument(argc, argv, 2, 1000), Argument(argc, argv, 3, 1000));
+		return 0;
+	}
+
+	printf("usage: %s boards [low] [high] [policy]\n", argv[0]);
+	printf("       %s lookahead [low] [high] [step] [stride]\n", argv[0]);
+	printf("       %s restarts [low] [high] [step] [stride] [seed] [threads]\n", argv[0]);
+	printf("       %s endgame [low] [high] [step] [stride] [squares]\n", argv[0]);
+	printf("       %s count [rows] [columns] [closed] [threads] [checkpoint]\n", argv[0]);
+	printf("       %s layout [rows] [columns] [policy]\n", argv[0]);
+	printf("       %s pages [rows] [columns] [policy]\n", argv[0]);
+	printf("       %s render [rows] [columns]\n", argv[0]);
+	printf("       %s graph [rows] [columns] [policy]\n", argv[0]);
+	printf("       %s repair [rows] [columns]\n", argv[0]);
+	return 1;
+}
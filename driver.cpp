@@ -3,6 +3,10 @@
 #endif
 
 #include "GameBoard.h"
+#include "TourCounter.h"
+#include "TourGenerator.h"
+#include "BoardRenderer.h"
+#include "TraceRecorder.h"
 #include <time.h>
 #include <stdio.h>
 
@@ -18,161 +22,38 @@ namespace
 	bool SHOW_SOLUTION = false;
 	bool SHOW_HTABLES = false;
 	bool ABORTED = false;
+	unsigned STOP_AT = 0;
+
+	// Prints every board, a row at a time.
+	BoardRenderer RENDERER;
+
+	// Records every message to a file when set, for tracereplay.
+	TraceRecorder *TRACE = 0;
 }
 
 void DumpBoard(int const *board, unsigned rows, unsigned columns)
 {
-	char ROWC[] = "----------";
-	char ROWS[] = "|";
-	unsigned cw = 5;
-	ROWC[cw] = 0;
-	ROWS[cw] = 0;
-
-	for (unsigned r = 0; r < rows; r++)
-	{
-		for (unsigned i = 0; i < columns; i++)
-			printf("%s", ROWC);
-		printf("-\n");
-		for (unsigned h = 0; h < 3; h++)
-		{
-			for (unsigned c = 0; c < columns; c++)
-			{
-				if (h == 1)
-				{
-					int value = board[r * columns + c];
-					if (value != -1)
-						printf("|%*d ", cw - 2, value);
-					else
-						printf("%s", ROWS);
-				}
-				else
-				{
-					printf("%s", ROWS);
-					printf( "  " );
-				}
-			}
-			printf("|\n");
-		}
-	}
-	for (unsigned i = 0; i < columns; i++)
-		printf("%s", ROWC);
-	printf("-\n");
+	RENDERER.Render(board, rows, columns, BoardRenderer::rsBOXED);
 }
 
 void DumpBoardFlat(int const *board, unsigned rows, unsigned columns)
 {
-	for (unsigned r = 0; r < rows; r++)
-	{
-		for (unsigned c = 0; c < columns; c++)
-		{
-			int value = board[r * columns + c];
-			if (value != -1)
-				printf("%6i", value);
-			else
-				printf(" ");
-		}
-		printf("\n");
-	}
+	RENDERER.Render(board, rows, columns, BoardRenderer::rsFLAT);
 }
 
 void DumpBoardFlat(double const *board, unsigned rows, unsigned columns)
 {
-	for (unsigned r = 0; r < rows; r++)
-	{
-		for (unsigned c = 0; c < columns; c++)
-		{
-			double value = board[r * columns + c];
-			printf(" %03.2f ", value);
-		}
-		printf("\n");
-	}
+	RENDERER.Render(board, rows, columns, BoardRenderer::rsFLAT);
 }
 
 void DumpBoard2(double const *board, unsigned rows, unsigned columns)
 {
-	char ROWC[] = "----------";
-	char ROWS[] = "| ";
-	unsigned cw = 5;
-	ROWC[cw] = 0;
-	ROWS[cw] = 0;
-
-	for (unsigned r = 0; r < rows; r++)
-	{
-		for (unsigned i = 0; i < columns; i++)
-			printf("%s", ROWC);
-		printf("-\n");
-		for (unsigned h = 0; h < 3; h++)
-		{
-			for (unsigned c = 0; c < columns; c++)
-			{
-				if (h == 1)
-				{
-					double value = board[r * columns + c];
-					if (value != -1)
-						printf("|%2.1f ", value);
-					else
-						printf("%s", ROWS);
-				}
-				else
-				{
-					printf("%s", ROWS);
-				}
-			}
-			printf("|\n");
-		}
-	}
-	for (unsigned i = 0; i < columns; i++)
-		printf("%s", ROWC);
-	printf("-\n");
+	RENDERER.Render(board, rows, columns, BoardRenderer::rsBOXED);
 }
 
 void DumpBoard2(int const *board, unsigned move, unsigned rows, unsigned columns, unsigned row, unsigned column, bool placing)
 {
-	char ROWC[] = "-----\0";
-	char ROWS[] = "|    \0";
-	unsigned cw = 5;
-
-	for (unsigned r = 0; r < rows; r++)
-	{
-		for (unsigned i = 0; i < columns; i++)
-			printf("%s", ROWC);
-		printf("-\n");
-		for (unsigned h = 0; h < 3; h++)
-		{
-			for (unsigned c = 0; c < columns; c++)
-			{
-				if (h == 1)
-				{
-					int value = board[r * columns + c];
-
-					char sign = placing ? '+' : '-';
-
-					if (value != -1)
-					{
-						if (r == row && c == column)
-							printf("|%*d%c", cw - 2, value, sign);
-						else
-							printf("|%*d ", cw - 2, value);
-					}
-					else
-					{
-						if (r == row && c == column)
-							printf("|%*d%c", cw - 2, move, sign);
-						else
-							printf("%s", ROWS);
-					}
-				}
-				else
-				{
-					printf("%s", ROWS);
-				}
-			}
-			printf("|\n");
-		}
-	}
-	for (unsigned i = 0; i < columns; i++)
-		printf("%s", ROWC);
-	printf("-\n");
+	RENDERER.RenderMove(board, move, rows, columns, row, column, placing);
 }
 
 void Pause(void)
@@ -187,6 +68,9 @@ void Pause(void)
 
 bool Callback(const GameBoard& gb, const int *board, GameBoard::BoardMessage message, unsigned move, unsigned rows, unsigned columns, unsigned row, unsigned column)
 {
+	if (TRACE && message != GameBoard::MSG_ABORT_CHECK)
+		TRACE->Record(message, move, row, column);
+
 	switch (message)
 	{
 	case GameBoard::MSG_PLACING:
@@ -247,6 +131,8 @@ void TestBoards(unsigned low, unsigned high, GameBoard::TourPolicy search)
 
 		if (search == GameBoard::tpHEURISTICS)
 			printf("Policy: HEURISTICS\n");
+		else if (search == GameBoard::tpLOOKAHEAD)
+			printf("Policy: LOOKAHEAD\n");
 		else
 			printf("Policy: STATIC\n");
 
@@ -305,6 +191,137 @@ void TestHeuristics(unsigned rows, unsigned cols, unsigned row, unsigned col)
 	}
 }
 
+void TestMask(unsigned rows, unsigned cols, unsigned row, unsigned col)
+{
+	// Blocks the four center squares.
+	bool *mask = new bool[rows * cols];
+	for (unsigned i = 0; i < rows * cols; i++)
+		mask[i] = true;
+	for (unsigned r = rows / 2 - 1; r <= rows / 2; r++)
+		for (unsigned c = cols / 2 - 1; c <= cols / 2; c++)
+			mask[r * cols + c] = false;
+
+	GameBoard gb(rows, cols, Callback, mask);
+	delete[] mask;
+
+	printf("\n************ Tour starting at: %u,%u\nBoard size %ux%u, center blocked\n", row + 1, col + 1, rows, cols);
+
+	bool tour = gb.KnightsTour(row, col, GameBoard::tpHEURISTICS);
+	if (tour)
+	{
+		printf("Board:\n");
+		DumpBoardFlat(gb.GetBoard(), rows, cols);
+	}
+}
+
+void TestLeaper(unsigned rows, unsigned cols, unsigned shortLeap, unsigned longLeap)
+{
+	GameBoard gb(rows, cols, Callback, 0, shortLeap, longLeap);
+
+	printf("\n************ Tour starting at: %u,%u\nBoard size %ux%u, (%u,%u)-leaper\n", 1, 1, rows, cols, shortLeap, longLeap);
+
+	bool tour = gb.KnightsTour(0, 0, GameBoard::tpHEURISTICS);
+	if (tour)
+	{
+		printf("Board:\n");
+		DumpBoardFlat(gb.GetBoard(), rows, cols);
+	}
+}
+
+bool StopCallback(const GameBoard&, const int *, GameBoard::BoardMessage message, unsigned move, unsigned, unsigned, unsigned, unsigned)
+{
+	// Stops the search once it has made STOP_AT moves.
+	return message == GameBoard::MSG_ABORT_CHECK && move >= STOP_AT;
+}
+
+void TestCheckpoint(unsigned rows, unsigned cols, unsigned row, unsigned col, unsigned stopAt)
+{
+	const char *path = "knights.ckpt";
+	STOP_AT = stopAt;
+
+	printf("\n************ Tour starting at: %u,%u\nBoard size %ux%u, stopped and resumed\n", row + 1, col + 1, rows, cols);
+
+	GameBoard stopped(rows, cols, StopCallback);
+	stopped.SetCheckpoint(path);
+	bool tour = stopped.KnightsTour(row, col, GameBoard::tpSTATIC);
+	printf("Stopped after %u moves\n", stopped.GetMoves());
+
+	if (!tour)
+	{
+		GameBoard resumed(rows, cols);
+		tour = resumed.KnightsTourResume(path);
+		printf("Resumed, %u moves in all\n", resumed.GetMoves());
+
+		if (tour)
+		{
+			printf("Board:\n");
+			DumpBoardFlat(resumed.GetBoard(), rows, cols);
+		}
+	}
+
+	remove(path);
+}
+
+void TestCounting(unsigned rows, unsigned cols, bool closed)
+{
+	GameBoard gb(rows, cols);
+	TourCounter counter(gb, closed);
+
+	unsigned long long *counts = new unsigned long long[rows * cols];
+	unsigned long long total = counter.CountAll(counts);
+
+	printf("\n************ Counting %s tours\nBoard size %ux%u\n", closed ? "closed" : "open", rows, cols);
+	for (unsigned r = 0; r < rows; r++)
+	{
+		for (unsigned c = 0; c < cols; c++)
+			printf("%10llu", counts[r * cols + c]);
+		printf("\n");
+	}
+	printf("Total: %llu\n", total);
+
+	delete[] counts;
+}
+
+void TestGenerator(unsigned rows, unsigned cols, unsigned row, unsigned col, unsigned tours)
+{
+	GameBoard gb(rows, cols);
+	unsigned count = 0;
+
+	printf("\n************ Tour starting at: %u,%u\nBoard size %ux%u, first %u tours\n", row + 1, col + 1, rows, cols, tours);
+
+	for (const TourGenerator::Event& event : TourGenerator::Tours(gb, row, col, GameBoard::tpHEURISTICS))
+	{
+		printf("Tour #%u ends at %u,%u after %u moves\n", ++count, event.row + 1, event.column + 1, gb.GetMoves());
+		if (count == tours)
+		{
+			DumpBoardFlat(gb.GetBoard(), rows, cols);
+			break;
+		}
+	}
+}
+
+void TestTrace(unsigned rows, unsigned cols, unsigned row, unsigned col, const char *path)
+{
+	printf("\n************ Tour starting at: %u,%u\nBoard size %ux%u, traced to %s\n", row + 1, col + 1, rows, cols, path);
+
+	TraceRecorder recorder(path, rows, cols);
+	if (!recorder.IsOpen())
+	{
+		if (static_cast<unsigned long long>(rows) * cols > TraceRecorder::maxSquares)
+			printf("Boards over %llu squares can't be traced.\n", TraceRecorder::maxSquares);
+		else
+			printf("Can't open %s.\n", path);
+		return;
+	}
+
+	GameBoard gb(rows, cols, Callback);
+	TRACE = &recorder;
+	gb.KnightsTour(row, col, GameBoard::tpSTATIC);
+	TRACE = 0;
+
+	printf("%llu events recorded, %llu stalls\n", recorder.GetEvents(), recorder.GetStalls());
+}
+
 int main(void)
 {
 	TestBoards(100, 100, GameBoard::tpHEURISTICS);
@@ -317,6 +334,14 @@ int main(void)
 	TestMessages();
 	PrintDebug();
 	TestHeuristics(6, 6, 0, 0);
+	TestMask(8, 8, 0, 0);
+	TestLeaper(10, 10, 2, 3);
+	TestLeaper(12, 12, 1, 4);
+	TestCheckpoint(6, 6, 0, 1, 100000);
+	TestCounting(5, 5, false);
+	TestCounting(6, 6, true);
+	TestGenerator(8, 8, 0, 0, 10);
+	TestTrace(6, 6, 0, 1, "knights.trace");
 	return 0;
 
 	unsigned rows = 5;
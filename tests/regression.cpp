@@ -0,0 +1,406 @@
+/******************************************************************************/
+/*!
+\file   regression.cpp
+\brief
+Pins the tours the solver finds, so changes to the search show up.
+
+Usage:
+  regression record golden
+  regression check golden [engine]
+
+The record mode runs the sweep below with KnightsTour on the
+row-major layout, and writes one line per case to golden: the board, the
+start, the policy, whether a tour was found, the moves made, and a hash of
+GetBoard(). Every search stops after a budget of moves, so the cases that
+find no tour are pinned too.
+
+The check mode runs each case from golden on every engine (or the one
+named) and sorts the results:
+  exact     the same board and move count as golden
+  changed   a different, valid tour, in no more moves
+  regressed a valid tour that took more moves than golden
+  failed    no tour where golden has one, or a board that isn't a tour
+Only regressed and failed cases fail the check. Changed cases are listed,
+so a change meant to leave the search alone can be seen to have done so.
+
+The engines are:
+  rows      KnightsTour on the row-major layout, which golden comes from
+  tiles     KnightsTour on 16x16 tiles
+  morton    KnightsTour in Z-order, on huge pages
+  steps     the first tour of TourGenerator, one square at a time
+  parallel  KnightsTourRestarts racing 4 threads for up to 1024 attempts;
+            random, so only the tour is checked, and a valid one counts
+            as exact
+  graph     HamiltonianSolver over a KnightGraph of the board
+
+*/
+/******************************************************************************/
+
+#include "GameBoard.h"
+#include "TourGenerator.h"
+#include "HamiltonianSolver.h"
+#include "KnightGraph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Every search stops after this many moves, plus two per square.
+	const unsigned BUDGET = 50000;
+	unsigned budget = 0;
+
+	const char *POLICIES[] = { "STATIC", "HEURISTICS", "LOOKAHEAD" };
+}
+
+// One line of golden.
+struct Case
+{
+	unsigned rows;
+	unsigned columns;
+	unsigned row;
+	unsigned column;
+	unsigned policy;
+	bool found;
+	unsigned moves;
+	unsigned long long hash;
+};
+
+// What an engine did with a case.
+struct Result
+{
+	bool found;
+	unsigned moves;
+	unsigned long long hash;
+	bool valid;
+};
+
+enum Verdict { vEXACT, vCHANGED, vREGRESSED, vFAILED };
+
+const char *VERDICTS[] = { "exact", "changed", "regressed", "failed" };
+
+bool Callback(const GameBoard&, const int *, GameBoard::BoardMessage message, unsigned move, unsigned, unsigned, unsigned, unsigned)
+{
+	return message == GameBoard::MSG_ABORT_CHECK && move >= budget;
+}
+
+// FNV-1a over the squares of board, row by row.
+unsigned long long Hash(int const *board, unsigned size)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for (unsigned i = 0; i < size; i++)
+	{
+		unsigned value = static_cast<unsigned>(board[i]);
+		for (unsigned b = 0; b < 4; b++)
+		{
+			hash ^= value & 0xff;
+			hash *= 1099511628211ULL;
+			value >>= 8;
+		}
+	}
+
+	return hash;
+}
+
+// True if board holds a knight's tour: every open square once, each a jump from the last.
+bool IsTour(const GameBoard& gb, int const *board)
+{
+	const int columns = static_cast<int>(gb.GetColumns());
+	const unsigned squares = gb.GetSquares();
+	std::vector<int> at(squares + 1, -1);
+
+	for (unsigned i = 0; i < gb.GetRows() * gb.GetColumns(); i++)
+	{
+		if (board[i] == -1)
+			continue;
+		if (board[i] < 1 || static_cast<unsigned>(board[i]) > squares || at[board[i]] != -1)
+			return false;
+		at[board[i]] = static_cast<int>(i);
+	}
+
+	for (unsigned move = 2; move <= squares; move++)
+	{
+		const int dr = abs(at[move] / columns - at[move - 1] / columns);
+		const int dc = abs(at[move] % columns - at[move - 1] % columns);
+		if (!((dr == 1 && dc == 2) || (dr == 2 && dc == 1)))
+			return false;
+	}
+
+	return true;
+}
+
+Result Finish(const GameBoard& gb, bool found)
+{
+	Result result;
+	result.found = found;
+	result.moves = gb.GetMoves();
+	result.hash = Hash(gb.GetBoard(), gb.GetRows() * gb.GetColumns());
+	result.valid = !found || IsTour(gb, gb.GetBoard());
+	return result;
+}
+
+Result RunLayout(const Case& c, GameBoard::BoardLayout layout, bool hugePages)
+{
+	GameBoard gb(c.rows, c.columns, Callback, 0, 1, 2, layout, hugePages);
+	budget = BUDGET + 2 * c.rows * c.columns;
+	const bool found = gb.KnightsTour(c.row, c.column, static_cast<GameBoard::TourPolicy>(c.policy));
+	return Finish(gb, found);
+}
+
+Result RunRows(const Case& c) { return RunLayout(c, GameBoard::blROWS, false); }
+Result RunTiles(const Case& c) { return RunLayout(c, GameBoard::blTILES, false); }
+Result RunMorton(const Case& c) { return RunLayout(c, GameBoard::blMORTON, true); }
+
+Result RunSteps(const Case& c)
+{
+	GameBoard gb(c.rows, c.columns);
+	TourGenerator tours = TourGenerator::Tours(gb, c.row, c.column, static_cast<GameBoard::TourPolicy>(c.policy));
+	return Finish(gb, tours.Next());
+}
+
+Result RunParallel(const Case& c)
+{
+	GameBoard gb(c.rows, c.columns);
+	const bool found = gb.KnightsTourRestarts(c.row, c.column, static_cast<GameBoard::TourPolicy>(c.policy), 1, 4, 1024);
+	return Finish(gb, found);
+}
+
+Result RunGraph(const Case& c)
+{
+	GameBoard gb(c.rows, c.columns);
+	KnightGraph graph(gb);
+	HamiltonianSolver<KnightGraph> solver(graph);
+	const HamiltonianSolver<KnightGraph>::Ordering orderings[] =
+		{ solver.hoNONE, solver.hoDEGREE, solver.hoLOOKAHEAD };
+
+	//KnightsTour turns away the boards with no tour before searching.
+	bool found = false;
+	if (GameBoard::IsTourPossible(c.rows, c.columns, c.row, c.column))
+		found = solver.Solve(graph.GetVertex(c.row, c.column), orderings[c.policy], BUDGET + 2 * c.rows * c.columns);
+
+	std::vector<int> board(c.rows * c.columns);
+	graph.GetBoard(solver.GetPath(), &board[0]);
+
+	Result result;
+	result.found = found;
+	result.moves = static_cast<unsigned>(solver.GetMoves());
+	result.hash = Hash(&board[0], c.rows * c.columns);
+	result.valid = !found || IsTour(gb, &board[0]);
+	return result;
+}
+
+// An engine, and the cases it can take.
+struct Engine
+{
+	const char *name;
+	Result (*run)(const Case& c);
+	bool exact;       // the board and moves can be compared with golden
+	bool toursOnly;   // only cases golden found a tour for, with a policy that has ties to break
+};
+
+const Engine ENGINES[] =
+{
+	{ "rows", RunRows, true, false },
+	{ "tiles", RunTiles, true, false },
+	{ "morton", RunMorton, true, false },
+	// without a budget, a case golden gave up on could run for ever.
+	{ "steps", RunSteps, true, true },
+	{ "parallel", RunParallel, false, true },
+	{ "graph", RunGraph, true, false }
+};
+
+Verdict Judge(const Engine& engine, const Case& c, const Result& result)
+{
+	if (!result.valid || (c.found && !result.found))
+		return vFAILED;
+
+	if (!engine.exact)
+		return vEXACT;
+
+	if (result.found == c.found && result.moves == c.moves && result.hash == c.hash)
+		return vEXACT;
+
+	return result.moves > c.moves ? vREGRESSED : vCHANGED;
+}
+
+// Adds every start of a rows x columns board that is a multiple of stride, for each policy.
+void AddBoard(std::vector<Case>& cases, unsigned rows, unsigned columns, unsigned stride, bool statics)
+{
+	for (unsigned policy = statics ? GameBoard::tpSTATIC : GameBoard::tpHEURISTICS; policy <= GameBoard::tpLOOKAHEAD; policy++)
+	{
+		for (unsigned r = 0; r < rows; r += stride)
+		{
+			for (unsigned c = 0; c < columns; c += stride)
+			{
+				Case added = { rows, columns, r, c, policy, false, 0, 0 };
+				cases.push_back(added);
+			}
+		}
+	}
+}
+
+// The sweep golden is recorded from.
+std::vector<Case> Sweep(void)
+{
+	std::vector<Case> cases;
+
+	//every start of the small boards, where the search backtracks most.
+	for (unsigned n = 5; n <= 12; n++)
+		AddBoard(cases, n, n, 1, n <= 8);
+	for (unsigned n = 3; n <= 9; n++)
+		AddBoard(cases, n, n + 1, 1, n <= 6);
+	AddBoard(cases, 3, 10, 1, true);
+	AddBoard(cases, 4, 9, 1, true);
+
+	//a spread of starts on larger boards.
+	AddBoard(cases, 20, 20, 3, false);
+	AddBoard(cases, 31, 30, 5, false);
+	AddBoard(cases, 50, 50, 7, false);
+	AddBoard(cases, 64, 64, 21, false);
+	AddBoard(cases, 100, 100, 33, false);
+	AddBoard(cases, 40, 150, 39, false);
+
+	return cases;
+}
+
+bool Record(const char *path)
+{
+	FILE *file = fopen(path, "w");
+	if (!file)
+	{
+		printf("Can't write %s.\n", path);
+		return false;
+	}
+
+	std::vector<Case> cases = Sweep();
+
+	fprintf(file, "# Golden results of KnightsTour on the row-major layout, from tests/regression.cpp.\n");
+	fprintf(file, "# rows columns row column policy found moves hash\n");
+
+	unsigned found = 0;
+	for (unsigned i = 0; i < cases.size(); i++)
+	{
+		Case& c = cases[i];
+		const Result result = RunRows(c);
+		c.found = result.found;
+		c.moves = result.moves;
+		c.hash = result.hash;
+		found += c.found;
+
+		fprintf(file, "%u %u %u %u %u %u %u %016llx\n", c.rows, c.columns, c.row, c.column, c.policy,
+			c.found ? 1 : 0, c.moves, c.hash);
+	}
+
+	fclose(file);
+	printf("Recorded %u cases, %u with tours, to %s\n", static_cast<unsigned>(cases.size()), found, path);
+	return true;
+}
+
+bool Load(const char *path, std::vector<Case>& cases)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		printf("Can't read %s.\n", path);
+		return false;
+	}
+
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+			continue;
+
+		Case c;
+		unsigned found;
+		if (sscanf(line, "%u %u %u %u %u %u %u %llx", &c.rows, &c.columns, &c.row, &c.column, &c.policy,
+			&found, &c.moves, &c.hash) != 8 || c.policy > GameBoard::tpLOOKAHEAD)
+		{
+			printf("Bad line in %s: %s", path, line);
+			fclose(file);
+			return false;
+		}
+
+		c.found = found != 0;
+		cases.push_back(c);
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool Check(const char *path, const char *only)
+{
+	std::vector<Case> cases;
+	if (!Load(path, cases))
+		return false;
+
+	bool passed = true;
+	unsigned engines = 0;
+
+	for (unsigned e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); e++)
+	{
+		const Engine& engine = ENGINES[e];
+		if (only && strcmp(only, engine.name))
+			continue;
+		++engines;
+
+		unsigned verdicts[4] = { 0 };
+		unsigned long long moves = 0;
+		unsigned long long goldenMoves = 0;
+
+		for (unsigned i = 0; i < cases.size(); i++)
+		{
+			const Case& c = cases[i];
+			if (engine.toursOnly && (!c.found || c.policy == GameBoard::tpSTATIC))
+				continue;
+
+			const Result result = engine.run(c);
+			const Verdict verdict = Judge(engine, c, result);
+			++verdicts[verdict];
+			moves += result.moves;
+			goldenMoves += c.moves;
+
+			if (verdict != vEXACT)
+			{
+				printf("  %-9s %-9s %ux%u from %u,%u %-10s moves %u, golden %u%s\n", engine.name, VERDICTS[verdict],
+					c.rows, c.columns, c.row, c.column, POLICIES[c.policy], result.moves, c.moves,
+					result.found ? "" : " (no tour)");
+			}
+		}
+
+		printf("%-9s exact %5u  changed %4u  regressed %4u  failed %4u", engine.name,
+			verdicts[vEXACT], verdicts[vCHANGED], verdicts[vREGRESSED], verdicts[vFAILED]);
+		if (engine.exact)
+			printf("  moves %llu, golden %llu", moves, goldenMoves);
+		printf("\n");
+
+		if (verdicts[vREGRESSED] || verdicts[vFAILED])
+			passed = false;
+	}
+
+	if (!engines)
+	{
+		printf("No engine named %s.\n", only);
+		return false;
+	}
+
+	return passed;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 2 && !strcmp(argv[1], "record"))
+		return Record(argv[2]) ? 0 : 1;
+
+	if (argc > 2 && !strcmp(argv[1], "check"))
+		return Check(argv[2], argc > 3 ? argv[3] : 0) ? 0 : 1;
+
+	printf("usage: %s record golden\n", argv[0]);
+	printf("       %s check golden [engine]\n", argv[0]);
+	return 1;
+}
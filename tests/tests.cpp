@@ -0,0 +1,684 @@
+/******************************************************************************/
+/*!
+\file   tests.cpp
+\brief
+Checks of the solver's results, run by ctest.
+
+Usage:
+  tests [name]
+
+Runs every test, or only the one named, and prints each one that fails.
+Returns 0 when all of them pass.
+
+*/
+/******************************************************************************/
+
+#include "GameBoard.h"
+#include "TourCounter.h"
+#include "TourGenerator.h"
+#include "BoardRenderer.h"
+#include "TraceRecorder.h"
+#include "HamiltonianSolver.h"
+#include "KnightGraph.h"
+#include "TourRules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+	// The checks that failed in the test being run.
+	unsigned FAILURES = 0;
+}
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			++FAILURES; \
+		} \
+	} while (0)
+
+// True if board holds a tour of gb's piece: every open square once, each a leap from the last.
+bool IsTour(const GameBoard& gb, int const *board)
+{
+	const unsigned rows = gb.GetRows();
+	const unsigned columns = gb.GetColumns();
+	const unsigned squares = gb.GetSquares();
+	std::vector<int> at(squares + 1, -1);
+
+	for (unsigned i = 0; i < rows * columns; i++)
+	{
+		if (board[i] == -1)
+			continue;
+		if (board[i] < 1 || static_cast<unsigned>(board[i]) > squares || at[board[i]] != -1)
+			return false;
+		at[board[i]] = static_cast<int>(i);
+	}
+
+	for (unsigned move = 2; move <= squares; move++)
+	{
+		const int dr = abs(at[move] / static_cast<int>(columns) - at[move - 1] / static_cast<int>(columns));
+		const int dc = abs(at[move] % static_cast<int>(columns) - at[move - 1] % static_cast<int>(columns));
+		const int lo = static_cast<int>(gb.GetShortLeap());
+		const int hi = static_cast<int>(gb.GetLongLeap());
+		if (!((dr == lo && dc == hi) || (dr == hi && dc == lo)))
+			return false;
+	}
+
+	return true;
+}
+
+void TestTours(void)
+{
+	const GameBoard::TourPolicy policies[] = { GameBoard::tpHEURISTICS, GameBoard::tpLOOKAHEAD };
+
+	for (unsigned p = 0; p < 2; p++)
+	{
+		for (unsigned n = 5; n <= 40; n++)
+		{
+			GameBoard gb(n, n);
+			CHECK(gb.KnightsTour(0, 0, policies[p]));
+			CHECK(IsTour(gb, gb.GetBoard()));
+		}
+	}
+
+	//the search keeps its frames off the call stack, so a board far deeper
+	//than the stack tours, on the main thread and on racing ones.
+	GameBoard deep(500, 500);
+	CHECK(deep.KnightsTour(0, 0, GameBoard::tpHEURISTICS));
+	CHECK(IsTour(deep, deep.GetBoard()));
+	CHECK(deep.KnightsTourRestarts(0, 0, GameBoard::tpHEURISTICS, 1, 2));
+	CHECK(IsTour(deep, deep.GetBoard()));
+
+	GameBoard small(6, 6);
+	CHECK(small.KnightsTour(0, 1, GameBoard::tpSTATIC));
+	CHECK(IsTour(small, small.GetBoard()));
+
+	//no tour can start off the corner of a 5x5 board's colour.
+	GameBoard odd(5, 5);
+	CHECK(!GameBoard::IsTourPossible(5, 5, 0, 1));
+	CHECK(!odd.KnightsTour(0, 1, GameBoard::tpHEURISTICS));
+}
+
+bool PLACED = false;
+
+bool PlacedCallback(const GameBoard&, const int *, GameBoard::BoardMessage message, unsigned, unsigned, unsigned, unsigned, unsigned)
+{
+	if (message == GameBoard::MSG_PLACING)
+		PLACED = true;
+	return false;
+}
+
+void TestPossible(void)
+{
+	//no open tour on 1xN but 1x1, 2xN, 3x3, 3x5, 3x6 or 4x4, from anywhere,
+	//and KnightsTour gives up on them without placing a piece.
+	const unsigned none[][2] = { { 1, 2 }, { 1, 8 }, { 2, 2 }, { 2, 9 }, { 3, 3 }, { 3, 5 }, { 3, 6 }, { 4, 4 } };
+	for (unsigned i = 0; i < sizeof(none) / sizeof(none[0]); i++)
+	{
+		for (unsigned turn = 0; turn < 2; turn++)
+		{
+			const unsigned rows = none[i][turn];
+			const unsigned columns = none[i][1 - turn];
+			GameBoard gb(rows, columns, PlacedCallback);
+
+			for (unsigned start = 0; start < rows * columns; start++)
+			{
+				CHECK(!GameBoard::IsTourPossible(rows, columns, start / columns, start % columns));
+
+				PLACED = false;
+				CHECK(!gb.KnightsTour(start / columns, start % columns, GameBoard::tpHEURISTICS));
+				CHECK(!PLACED && gb.GetMoves() == 0);
+			}
+		}
+	}
+
+	const unsigned some[][2] = { { 1, 1 }, { 3, 4 }, { 3, 7 }, { 4, 5 }, { 5, 5 } };
+	for (unsigned i = 0; i < sizeof(some) / sizeof(some[0]); i++)
+	{
+		CHECK(GameBoard::IsTourPossible(some[i][0], some[i][1], 0, 0));
+		CHECK(GameBoard::IsTourPossible(some[i][1], some[i][0], 0, 0));
+	}
+
+	//no closed tour with an odd number of squares, on 1xN, 2xN or 4xN, or on
+	//3x4, 3x6 or 3x8.
+	const unsigned open[][2] = { { 5, 5 }, { 7, 9 }, { 1, 6 }, { 2, 6 }, { 4, 6 }, { 4, 8 }, { 3, 4 }, { 3, 6 }, { 3, 8 } };
+	for (unsigned i = 0; i < sizeof(open) / sizeof(open[0]); i++)
+	{
+		CHECK(!GameBoard::IsTourPossible(open[i][0], open[i][1], 0, 0, true));
+		CHECK(!GameBoard::IsTourPossible(open[i][1], open[i][0], 0, 0, true));
+	}
+
+	const unsigned closed[][2] = { { 3, 10 }, { 5, 6 }, { 6, 6 }, { 8, 8 } };
+	for (unsigned i = 0; i < sizeof(closed) / sizeof(closed[0]); i++)
+		CHECK(GameBoard::IsTourPossible(closed[i][0], closed[i][1], 0, 0, true));
+
+	//an odd board's tours start on the corners' colour, and never off the board.
+	GameBoard odd(7, 7, PlacedCallback);
+	PLACED = false;
+	CHECK(!odd.KnightsTour(0, 1, GameBoard::tpSTATIC));
+	CHECK(!PLACED && odd.GetMoves() == 0);
+	CHECK(!GameBoard::IsTourPossible(7, 7, 7, 0));
+}
+
+void TestLayouts(void)
+{
+	GameBoard rows(64, 48, 0, 0, 1, 2, GameBoard::blROWS);
+	GameBoard tiles(64, 48, 0, 0, 1, 2, GameBoard::blTILES);
+	GameBoard morton(64, 48, 0, 0, 1, 2, GameBoard::blMORTON, true);
+
+	//no lookahead or random table before a tour, and never a random one
+	//unless restarted.
+	CHECK(tiles.GetLTable() == 0 && tiles.GetRTable() == 0);
+
+	CHECK(rows.KnightsTour(3, 5, GameBoard::tpHEURISTICS));
+	CHECK(tiles.KnightsTour(3, 5, GameBoard::tpHEURISTICS));
+	CHECK(morton.KnightsTour(3, 5, GameBoard::tpHEURISTICS));
+
+	//the layout only changes where squares are kept, not the tour.
+	CHECK(!memcmp(rows.GetBoard(), tiles.GetBoard(), 64 * 48 * sizeof(int)));
+	CHECK(!memcmp(rows.GetBoard(), morton.GetBoard(), 64 * 48 * sizeof(int)));
+	CHECK(rows.GetMoves() == tiles.GetMoves() && rows.GetMoves() == morton.GetMoves());
+	CHECK(tiles.GetLTable() != 0 && tiles.GetRTable() == 0);
+
+	//a board asked for again after another tour is the new one.
+	CHECK(tiles.KnightsTour(0, 0, GameBoard::tpHEURISTICS));
+	CHECK(IsTour(tiles, tiles.GetBoard()) && tiles.GetBoard()[0] == 1);
+}
+
+void TestMaskAndLeapers(void)
+{
+	bool mask[8 * 8];
+	for (unsigned i = 0; i < 8 * 8; i++)
+		mask[i] = true;
+	mask[3 * 8 + 3] = mask[3 * 8 + 4] = mask[4 * 8 + 3] = mask[4 * 8 + 4] = false;
+
+	GameBoard masked(8, 8, 0, mask);
+	CHECK(masked.GetSquares() == 60);
+	CHECK(masked.KnightsTour(0, 0, GameBoard::tpHEURISTICS));
+	CHECK(IsTour(masked, masked.GetBoard()));
+	CHECK(masked.GetBoard()[3 * 8 + 3] == -1);
+
+	GameBoard giraffe(10, 10, 0, 0, 1, 4);
+	CHECK(giraffe.KnightsTour(0, 0, GameBoard::tpHEURISTICS));
+	CHECK(IsTour(giraffe, giraffe.GetBoard()));
+}
+
+void TestRestarts(void)
+{
+	GameBoard gb(30, 31);
+	CHECK(gb.KnightsTourRestarts(0, 0, GameBoard::tpHEURISTICS, 7, 1));
+	CHECK(IsTour(gb, gb.GetBoard()));
+
+	//the same seed finds the same tour.
+	GameBoard again(30, 31);
+	CHECK(again.KnightsTourRestarts(0, 0, GameBoard::tpHEURISTICS, 7, 1));
+	CHECK(!memcmp(gb.GetBoard(), again.GetBoard(), 30 * 31 * sizeof(int)));
+
+	GameBoard endgame(20, 20);
+	endgame.SetEndgame(16);
+	CHECK(endgame.KnightsTour(0, 0, GameBoard::tpHEURISTICS));
+	CHECK(IsTour(endgame, endgame.GetBoard()));
+}
+
+unsigned STOP_AT = 0;
+
+bool StopCallback(const GameBoard&, const int *, GameBoard::BoardMessage message, unsigned move, unsigned, unsigned, unsigned, unsigned)
+{
+	return message == GameBoard::MSG_ABORT_CHECK && move >= STOP_AT;
+}
+
+void TestCheckpoint(void)
+{
+	const char *path = "tests.ckpt";
+
+	GameBoard whole(6, 6);
+	CHECK(whole.KnightsTour(0, 1, GameBoard::tpSTATIC));
+
+	//stopped halfway through the whole search.
+	STOP_AT = whole.GetMoves() / 2;
+	GameBoard stopped(6, 6, StopCallback);
+	stopped.SetCheckpoint(path);
+	CHECK(!stopped.KnightsTour(0, 1, GameBoard::tpSTATIC));
+
+	//picks up where it stopped, and ends exactly where the whole search did.
+	GameBoard resumed(6, 6);
+	CHECK(resumed.KnightsTourResume(path));
+	CHECK(!memcmp(whole.GetBoard(), resumed.GetBoard(), 6 * 6 * sizeof(int)));
+	CHECK(whole.GetMoves() == resumed.GetMoves());
+
+	//a board with as many squares, blocked elsewhere, refuses the snapshot.
+	bool mask[6 * 6];
+	for (unsigned i = 0; i < 6 * 6; i++)
+		mask[i] = true;
+	mask[5 * 6 + 5] = false;
+	STOP_AT = 100;
+	GameBoard corner(6, 6, StopCallback, mask);
+	corner.SetCheckpoint(path);
+	CHECK(!corner.KnightsTour(0, 1, GameBoard::tpSTATIC));
+
+	mask[5 * 6 + 5] = true;
+	mask[5 * 6 + 2] = false;
+	GameBoard other(6, 6, 0, mask);
+	CHECK(corner.GetMaskHash() != other.GetMaskHash());
+	CHECK(!other.KnightsTourResume(path) && other.GetMoves() == 0);
+
+	remove(path);
+}
+
+void TestCounting(void)
+{
+	GameBoard gb(5, 5);
+	TourCounter counter(gb, false, 2);
+
+	CHECK(counter.CountFrom(0, 0) == 304);
+
+	std::vector<unsigned long long> counts(5 * 5);
+	CHECK(counter.CountAll(&counts[0]) == 1728);
+	CHECK(counts[2 * 5 + 2] == 64);
+	CHECK(counts[0 * 5 + 1] == 0);
+
+	GameBoard six(6, 6);
+	TourCounter closed(six, true, 2);
+	CHECK(closed.CountFrom(0, 0) == 2 * 9862);
+
+	//a count checkpointed on many threads is carried on by one, job for job.
+	const char *path = "tests.count";
+	remove(path);
+	TourCounter many(gb, false, 64);
+	many.SetCheckpoint(path);
+	CHECK(many.CountFrom(0, 0) == 304 && many.GetResumed() == 0);
+
+	TourCounter one(gb, false, 1);
+	one.SetCheckpoint(path);
+	CHECK(one.CountFrom(0, 0) == 304);
+	CHECK(one.GetJobs() == many.GetJobs() && one.GetResumed() == one.GetJobs());
+	remove(path);
+
+	//the mirror image of a blocked board splits into as many jobs, but
+	//doesn't take the other's.
+	bool mask[5 * 5];
+	for (unsigned i = 0; i < 5 * 5; i++)
+		mask[i] = true;
+	mask[0 * 5 + 4] = false;
+	GameBoard right(5, 5, 0, mask);
+	TourCounter first(right, false, 2);
+	first.SetCheckpoint(path);
+	const unsigned long long tours = first.CountFrom(0, 0);
+
+	mask[0 * 5 + 4] = true;
+	mask[4 * 5 + 0] = false;
+	GameBoard below(5, 5, 0, mask);
+	TourCounter second(below, false, 2);
+	second.SetCheckpoint(path);
+	CHECK(second.CountFrom(0, 0) == tours);
+	CHECK(second.GetJobs() == first.GetJobs() && second.GetResumed() == 0);
+	remove(path);
+}
+
+void TestGenerator(void)
+{
+	GameBoard first(5, 5);
+	CHECK(first.KnightsTour(0, 0, GameBoard::tpHEURISTICS));
+
+	GameBoard gb(5, 5);
+	unsigned tours = 0;
+	for (const TourGenerator::Event& event : TourGenerator::Tours(gb, 0, 0, GameBoard::tpHEURISTICS))
+	{
+		CHECK(event.message == GameBoard::MSG_FINISHED_OK);
+		CHECK(IsTour(gb, gb.GetBoard()));
+		if (!tours++)
+			CHECK(!memcmp(first.GetBoard(), gb.GetBoard(), 5 * 5 * sizeof(int)));
+	}
+	CHECK(tours == 304);
+}
+
+// The text renderer writes for board.
+std::string Rendered(int const *board, unsigned rows, unsigned columns, BoardRenderer::RenderStyle style)
+{
+	FILE *file = tmpfile();
+	{
+		BoardRenderer renderer(file);
+		renderer.Render(board, rows, columns, style);
+	}
+
+	std::string text(static_cast<size_t>(ftell(file)), ' ');
+	rewind(file);
+	if (!text.empty() && fread(&text[0], 1, text.size(), file) != text.size())
+		text.clear();
+	fclose(file);
+
+	return text;
+}
+
+void TestRenderer(void)
+{
+	const int board[] = { 1, -1, 12, 1234567, 0, -5 };
+
+	CHECK(Rendered(board, 2, 3, BoardRenderer::rsFLAT) ==
+		"       1              12\n"
+		" 1234567       0      -5\n");
+	CHECK(Rendered(board, 2, 3, BoardRenderer::rsCSV) == "1,,12\n1234567,0,-5\n");
+	CHECK(Rendered(board, 1, 2, BoardRenderer::rsBOXED) ==
+		"-----------\n"
+		"|    |    |\n"
+		"|  1 |    |\n"
+		"|    |    |\n"
+		"-----------\n");
+}
+
+const char *TRACE_PATH = "tests.trace";
+TraceRecorder *TRACE = 0;
+
+bool TraceCallback(const GameBoard&, const int *, GameBoard::BoardMessage message, unsigned move, unsigned, unsigned, unsigned row, unsigned column)
+{
+	if (message != GameBoard::MSG_ABORT_CHECK)
+		TRACE->Record(message, move, row, column);
+	return false;
+}
+
+void TestTrace(void)
+{
+	unsigned long long events;
+	{
+		//a small ring, so the search laps it and has to wait on the writer.
+		TraceRecorder recorder(TRACE_PATH, 6, 6, 1024);
+		CHECK(recorder.IsOpen());
+
+		TRACE = &recorder;
+		GameBoard gb(6, 6, TraceCallback);
+		CHECK(gb.KnightsTour(0, 1, GameBoard::tpSTATIC));
+		TRACE = 0;
+
+		events = recorder.GetEvents();
+	}
+
+	FILE *file = fopen(TRACE_PATH, "rb");
+	CHECK(file != 0);
+	if (!file)
+		return;
+
+	unsigned rows = 0, columns = 0;
+	CHECK(TraceRecorder::ReadHeader(file, rows, columns));
+	CHECK(rows == 6 && columns == 6);
+
+	//every event arrives, in order, and the last one is the finished tour.
+	std::vector<TraceRecorder::Event> trace(static_cast<size_t>(events) + 1);
+	CHECK(fread(&trace[0], sizeof(TraceRecorder::Event), trace.size(), file) == events);
+	fclose(file);
+	remove(TRACE_PATH);
+
+	bool ordered = true;
+	for (unsigned long long i = 1; i < events; i++)
+		ordered = ordered && trace[i].move > trace[i - 1].move;
+	CHECK(ordered);
+	CHECK(events && trace[events - 1].message == GameBoard::MSG_FINISHED_OK);
+
+	//a board whose squares don't fit an event isn't traced at all.
+	TraceRecorder huge(TRACE_PATH, 1 << 15, 1 << 14);
+	CHECK(!huge.IsOpen());
+	file = fopen(TRACE_PATH, "rb");
+	CHECK(file == 0);
+	if (file)
+		fclose(file);
+}
+
+// A graph from its edges, each listed once.
+CsrGraph MakeGraph(unsigned vertices, const unsigned (*edges)[2], unsigned count)
+{
+	std::vector<unsigned> offsets(vertices + 1, 0);
+	for (unsigned i = 0; i < count; i++)
+	{
+		++offsets[edges[i][0] + 1];
+		++offsets[edges[i][1] + 1];
+	}
+	for (unsigned v = 0; v < vertices; v++)
+		offsets[v + 1] += offsets[v];
+
+	std::vector<unsigned> targets(offsets[vertices]);
+	std::vector<unsigned> next(offsets.begin(), offsets.end() - 1);
+	for (unsigned i = 0; i < count; i++)
+	{
+		targets[next[edges[i][0]]++] = edges[i][1];
+		targets[next[edges[i][1]]++] = edges[i][0];
+	}
+
+	return CsrGraph(offsets, targets);
+}
+
+// True if path visits every vertex of graph once, along its edges.
+bool IsPath(const CsrGraph& graph, const std::vector<unsigned>& path)
+{
+	std::vector<bool> seen(graph.GetVertices(), false);
+	if (path.size() != graph.GetVertices())
+		return false;
+
+	for (unsigned i = 0; i < path.size(); i++)
+	{
+		if (seen[path[i]])
+			return false;
+		seen[path[i]] = true;
+
+		bool edge = i == 0;
+		graph.ForEachNeighbor(path[i], [&](unsigned n) { edge = edge || n == path[i - 1]; });
+		if (!edge)
+			return false;
+	}
+
+	return true;
+}
+
+void TestGraph(void)
+{
+	//the Petersen graph: a path through every vertex, though no cycle.
+	const unsigned petersen[][2] =
+	{
+		{ 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 4 }, { 4, 0 },
+		{ 5, 7 }, { 7, 9 }, { 9, 6 }, { 6, 8 }, { 8, 5 },
+		{ 0, 5 }, { 1, 6 }, { 2, 7 }, { 3, 8 }, { 4, 9 }
+	};
+	const CsrGraph graph = MakeGraph(10, petersen, 15);
+	HamiltonianSolver<CsrGraph> solver(graph);
+
+	for (unsigned start = 0; start < 10; start++)
+	{
+		CHECK(solver.Solve(start, solver.hoNONE) && IsPath(graph, solver.GetPath()));
+		CHECK(solver.Solve(start, solver.hoDEGREE) && IsPath(graph, solver.GetPath()));
+		CHECK(solver.Solve(start, solver.hoLOOKAHEAD) && IsPath(graph, solver.GetPath()));
+	}
+
+	//a star has no path through all its leaves.
+	const unsigned star[][2] = { { 0, 1 }, { 0, 2 }, { 0, 3 } };
+	const CsrGraph stars = MakeGraph(4, star, 3);
+	HamiltonianSolver<CsrGraph> none(stars);
+	CHECK(!none.Solve(0, none.hoNONE));
+	CHECK(!none.Solve(1, none.hoDEGREE));
+	CHECK(none.GetPath().size() == 1);
+
+	//a graph with no edges at all has nowhere to go from its start.
+	const CsrGraph apart(std::vector<unsigned>(3, 0), std::vector<unsigned>());
+	HamiltonianSolver<CsrGraph> stuck(apart);
+	CHECK(!stuck.Solve(0, stuck.hoLOOKAHEAD) && stuck.GetPath().size() == 1);
+
+	//candidates joined to each other change each other's sums as they are
+	//tried and taken back. From 6 the search backtracks through such a heap.
+	const unsigned triangles[][2] =
+	{
+		{ 0, 3 }, { 0, 5 }, { 0, 6 }, { 1, 3 }, { 2, 4 }, { 2, 7 },
+		{ 3, 4 }, { 3, 6 }, { 4, 5 }, { 4, 7 }, { 5, 6 }, { 6, 7 }
+	};
+	const CsrGraph joined = MakeGraph(8, triangles, 12);
+	HamiltonianSolver<CsrGraph> rebuilt(joined);
+	CHECK(rebuilt.Solve(6, rebuilt.hoLOOKAHEAD) && IsPath(joined, rebuilt.GetPath()));
+	CHECK(rebuilt.GetMoves() > 8);
+
+	//on a board, the solver finds the tour KnightsTour does, in as many moves.
+	for (unsigned p = GameBoard::tpSTATIC; p <= GameBoard::tpLOOKAHEAD; p++)
+	{
+		GameBoard gb(8, 8, 0, 0, 1, 2, GameBoard::blTILES);
+		CHECK(gb.KnightsTour(2, 3, static_cast<GameBoard::TourPolicy>(p)));
+
+		KnightGraph knights(gb);
+		HamiltonianSolver<KnightGraph> tours(knights);
+		CHECK(tours.Solve(knights.GetVertex(2, 3), static_cast<HamiltonianSolver<KnightGraph>::Ordering>(p)));
+		CHECK(tours.GetMoves() == gb.GetMoves());
+
+		std::vector<int> board(8 * 8);
+		knights.GetBoard(tours.GetPath(), &board[0]);
+		CHECK(!memcmp(gb.GetBoard(), &board[0], 8 * 8 * sizeof(int)));
+	}
+}
+
+void TestRepair(void)
+{
+	GameBoard gb(30, 30);
+	CHECK(gb.KnightsTour(0, 0, GameBoard::tpHEURISTICS));
+	std::vector<int> old(gb.GetBoard(), gb.GetBoard() + 30 * 30);
+	std::vector<unsigned> at(30 * 30 + 1);
+	for (unsigned i = 0; i < 30 * 30; i++)
+		at[old[i]] = i;
+
+	//nothing changed, nothing moves.
+	GameBoard same(30, 30);
+	CHECK(same.KnightsTourRepair(&old[0], 0, 0));
+	CHECK(!memcmp(same.GetBoard(), &old[0], 30 * 30 * sizeof(int)));
+	CHECK(same.GetMoves() == 0);
+
+	//two squares of either colour blocked in the middle of the tour.
+	bool mask[30 * 30];
+	for (unsigned i = 0; i < 30 * 30; i++)
+		mask[i] = i != at[400] && i != at[401];
+	GameBoard blocked(30, 30, 0, mask);
+	CHECK(blocked.KnightsTourRepair(&old[0], 0, 0));
+	CHECK(IsTour(blocked, blocked.GetBoard()));
+	CHECK(blocked.GetBoard()[at[400]] == -1 && blocked.GetBoard()[0] == 1);
+
+	//the tour kept after a change isn't counted as moves.
+	for (unsigned i = 0; i < 30 * 30; i++)
+		mask[i] = i != at[200] && i != at[201];
+	GameBoard early(30, 30, 0, mask);
+	CHECK(early.KnightsTourRepair(&old[0], 0, 0));
+	CHECK(IsTour(early, early.GetBoard()));
+	CHECK(early.GetMoves() < 30 * 30 - 200);
+
+	//a square the old tour lost goes back in.
+	std::vector<int> lost(old);
+	lost[at[450]] = 0;
+	GameBoard found(30, 30);
+	CHECK(found.KnightsTourRepair(&lost[0], 0, 0));
+	CHECK(IsTour(found, found.GetBoard()));
+
+	//a new start, and a given end.
+	GameBoard started(30, 30);
+	CHECK(started.KnightsTourRepair(&old[0], at[7] / 30, at[7] % 30));
+	CHECK(IsTour(started, started.GetBoard()));
+	CHECK(started.GetBoard()[at[7]] == 1);
+
+	GameBoard ended(30, 30);
+	CHECK(ended.KnightsTourRepair(&old[0], 0, 0, at[890] / 30, at[890] % 30));
+	CHECK(IsTour(ended, ended.GetBoard()));
+	CHECK(ended.GetBoard()[0] == 1 && ended.GetBoard()[at[890]] == 900);
+
+	//an end of the start's colour can't be reached on an even board.
+	GameBoard colour(30, 30);
+	CHECK(!colour.KnightsTourRepair(&old[0], 0, 0, at[891] / 30, at[891] % 30));
+}
+
+//the candidates PruneDeadEnds keeps of three, given their degrees.
+static unsigned Kept(const unsigned *degrees, const unsigned end)
+{
+	unsigned moves[3] = { degrees[0], degrees[1], degrees[2] };
+	unsigned candidates[3] = { 0, 1, 2 };
+	unsigned forced[3];
+	unsigned forcedCount = 0;
+
+	const unsigned count = PruneDeadEnds(candidates, 3, 5, end,
+	                                     [&moves](unsigned n) { return moves[n]; },
+	                                     [&moves](unsigned n) { ++moves[n]; }, forced, forcedCount);
+
+	unsigned kept = 0;
+	for (unsigned i = 0; i < count; i++)
+		kept |= 1u << candidates[i];
+	return kept;
+}
+
+void TestPrune(void)
+{
+	//a search gives a square its degree back when it takes back a move to it,
+	//or drops it as a candidate, though the square it came from stays on the
+	//path. Degrees read that way are too high, never too low, and must only
+	//make the pruning keep more. One too high is enough to change it.
+	for (unsigned code = 0; code < 4 * 4 * 4; code++)
+	{
+		const unsigned exact[3] = { code & 3, (code >> 2) & 3, (code >> 4) & 3 };
+
+		for (unsigned high = 0; high < 8; high++)
+		{
+			const unsigned read[3] = { exact[0] + (high & 1), exact[1] + ((high >> 1) & 1), exact[2] + (high >> 2) };
+
+			for (unsigned end = 0; end < 2; end++)
+			{
+				const unsigned kept = Kept(exact, end ? 0 : ~0u);
+				CHECK((Kept(read, end ? 0 : ~0u) & kept) == kept);
+			}
+		}
+	}
+}
+
+struct Test
+{
+	const char *name;
+	void (*run)(void);
+};
+
+const Test TESTS[] =
+{
+	{ "tours", TestTours },
+	{ "possible", TestPossible },
+	{ "layouts", TestLayouts },
+	{ "mask", TestMaskAndLeapers },
+	{ "restarts", TestRestarts },
+	{ "checkpoint", TestCheckpoint },
+	{ "counting", TestCounting },
+	{ "generator", TestGenerator },
+	{ "renderer", TestRenderer },
+	{ "trace", TestTrace },
+	{ "graph", TestGraph },
+	{ "repair", TestRepair },
+	{ "prune", TestPrune }
+};
+
+int main(int argc, char **argv)
+{
+	unsigned run = 0;
+	unsigned failed = 0;
+
+	for (unsigned i = 0; i < sizeof(TESTS) / sizeof(TESTS[0]); i++)
+	{
+		if (argc > 1 && strcmp(argv[1], TESTS[i].name))
+			continue;
+
+		FAILURES = 0;
+		TESTS[i].run();
+		printf("%-12s %s\n", TESTS[i].name, FAILURES ? "FAILED" : "ok");
+
+		++run;
+		if (FAILURES)
+			++failed;
+	}
+
+	if (!run)
+	{
+		printf("No test named %s.\n", argc > 1 ? argv[1] : "");
+		return 1;
+	}
+
+	printf("%u of %u tests passed\n", run - failed, run);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,268 @@
+/******************************************************************************/
+/*!
+\file   tracereplay.cpp
+\brief
+Replays a search traced by TraceRecorder.
+
+Usage:
+  tracereplay trace summary
+  tracereplay trace events [first] [count]
+  tracereplay trace board [event]
+  tracereplay trace heat
+
+The summary mode counts the events, the deepest the search got, and where
+in the tour it backed off.
+
+The events mode prints the events as the driver's SHOW_MESSAGES does,
+numbered from 1.
+
+The board mode replays the trace up to an event (the last one by default)
+and prints the board as it was then, with the event's square marked.
+
+The heat mode prints how many times the search backed off to each square.
+
+Every event gives the square the knight stands on before its next move, and
+if it got there by placing it or by taking squares back. A square already
+on the board is where the search backed off to; the others are placed on
+top. Squares placed and taken back between two events (dead ends) aren't in
+the trace, only the moves they cost.
+
+*/
+/******************************************************************************/
+
+#include "TraceRecorder.h"
+#include "BoardRenderer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+namespace
+{
+	// Events read from the file at a time.
+	const unsigned CHUNK = 1 << 16;
+
+	// Backtracks are tallied over this many stretches of the tour.
+	const unsigned BANDS = 10;
+
+	const char *MESSAGES[] = { "Finished", "Failed", "Abort check", "Placing at", "Removing from" };
+}
+
+// The search as the trace has it so far.
+class Replay
+{
+public:
+	Replay(unsigned rows, unsigned columns)
+		: board(rows * columns, 0)
+	{
+	}
+
+	// Moves the top of the search to cell, placing it or taking back the squares above it.
+	void Apply(const TraceRecorder::Event& event)
+	{
+		if (event.message == GameBoard::MSG_FINISHED_FAIL || event.message == GameBoard::MSG_ABORT_CHECK)
+			return;
+
+		const unsigned cell = event.cell;
+		if (board[cell])
+		{
+			while (!path.empty() && path.back() != cell)
+			{
+				board[path.back()] = 0;
+				path.pop_back();
+			}
+		}
+		else
+		{
+			path.push_back(cell);
+			board[cell] = static_cast<int>(path.size());
+		}
+	}
+
+	std::vector<int> board;
+	std::vector<unsigned> path;
+};
+
+// Reads the events of file in chunks, handing each one to visit with its number.
+// Stops at an event that can't be from a board of squares squares.
+template< class Visit >
+unsigned long long ForEachEvent(FILE *file, unsigned squares, Visit visit)
+{
+	std::vector<TraceRecorder::Event> events(CHUNK);
+	unsigned long long count = 0;
+
+	size_t read;
+	while ((read = fread(&events[0], sizeof(TraceRecorder::Event), CHUNK, file)) > 0)
+	{
+		for (size_t i = 0; i < read; i++)
+		{
+			if (events[i].cell >= squares || events[i].message > GameBoard::MSG_REMOVING)
+			{
+				printf("Event %llu is damaged.\n", count + 1);
+				return count;
+			}
+
+			if (!visit(++count, events[i]))
+				return count;
+		}
+	}
+
+	return count;
+}
+
+void Summary(FILE *file, unsigned rows, unsigned columns)
+{
+	Replay replay(rows, columns);
+	unsigned long long messages[GameBoard::MSG_REMOVING + 1] = { 0 };
+	unsigned long long bands[BANDS] = { 0 };
+	unsigned long long lastMove = 0;
+	unsigned deepest = 0;
+	unsigned longestBacktrack = 0;
+	const unsigned squares = rows * columns;
+
+	const unsigned long long events = ForEachEvent(file, rows * columns, [&](unsigned long long, const TraceRecorder::Event& event)
+	{
+		const unsigned depth = static_cast<unsigned>(replay.path.size());
+		replay.Apply(event);
+
+		++messages[event.message];
+		lastMove = event.move;
+
+		const unsigned now = static_cast<unsigned>(replay.path.size());
+		deepest = now > deepest ? now : deepest;
+		if (event.message == GameBoard::MSG_REMOVING && now)
+		{
+			++bands[static_cast<unsigned long long>(now - 1) * BANDS / squares];
+			longestBacktrack = depth - now > longestBacktrack ? depth - now : longestBacktrack;
+		}
+		return true;
+	});
+
+	printf("Board %ux%u, %llu events, %llu moves\n", rows, columns, events, lastMove);
+	for (unsigned i = 0; i <= GameBoard::MSG_REMOVING; i++)
+	{
+		if (i != GameBoard::MSG_ABORT_CHECK)
+			printf("  %-14s %12llu\n", MESSAGES[i], messages[i]);
+	}
+	printf("Deepest: %u of %u squares\n", deepest, squares);
+	printf("Longest backtrack: %u squares\n", longestBacktrack);
+	printf("Backtracks by depth:\n");
+	for (unsigned i = 0; i < BANDS; i++)
+		printf("  %3u%% - %3u%%  %12llu\n", i * 100 / BANDS, (i + 1) * 100 / BANDS, bands[i]);
+}
+
+void Events(FILE *file, unsigned rows, unsigned columns, unsigned long long first, unsigned long long count)
+{
+	ForEachEvent(file, rows * columns, [&](unsigned long long number, const TraceRecorder::Event& event)
+	{
+		if (number < first)
+			return true;
+		if (count && number >= first + count)
+			return false;
+
+		printf("%llu: Move: %u, %s %u,%u.\n", number, event.move, MESSAGES[event.message],
+			event.cell / columns + 1, event.cell % columns + 1);
+		return true;
+	});
+}
+
+void Board(FILE *file, unsigned rows, unsigned columns, unsigned long long last)
+{
+	Replay replay(rows, columns);
+	TraceRecorder::Event at = TraceRecorder::Event();
+	unsigned long long number = 0;
+
+	ForEachEvent(file, rows * columns, [&](unsigned long long n, const TraceRecorder::Event& event)
+	{
+		if (last && n > last)
+			return false;
+
+		replay.Apply(event);
+		at = event;
+		number = n;
+		return true;
+	});
+
+	if (!number)
+	{
+		printf("No events.\n");
+		return;
+	}
+
+	printf("Event %llu: Move: %u, %s %u,%u, %u squares down\n", number, at.move, MESSAGES[at.message],
+		at.cell / columns + 1, at.cell % columns + 1, static_cast<unsigned>(replay.path.size()));
+
+	BoardRenderer renderer;
+	renderer.RenderMove(&replay.board[0], static_cast<unsigned>(replay.path.size()), rows, columns,
+		at.cell / columns, at.cell % columns, at.message != GameBoard::MSG_REMOVING);
+}
+
+void Heat(FILE *file, unsigned rows, unsigned columns)
+{
+	std::vector<int> heat(rows * columns, 0);
+
+	ForEachEvent(file, rows * columns, [&](unsigned long long, const TraceRecorder::Event& event)
+	{
+		if (event.message == GameBoard::MSG_REMOVING)
+			++heat[event.cell];
+		return true;
+	});
+
+	BoardRenderer renderer;
+	renderer.Render(&heat[0], rows, columns, BoardRenderer::rsFLAT);
+}
+
+unsigned long long Argument(int argc, char **argv, int index, unsigned long long fallback)
+{
+	if (argc > index)
+		return strtoull(argv[index], 0, 10);
+	return fallback;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: %s trace summary\n", argv[0]);
+		printf("       %s trace events [first] [count]\n", argv[0]);
+		printf("       %s trace board [event]\n", argv[0]);
+		printf("       %s trace heat\n", argv[0]);
+		return 1;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	if (!file)
+	{
+		printf("Can't open %s.\n", argv[1]);
+		return 1;
+	}
+
+	unsigned rows, columns;
+	if (!TraceRecorder::ReadHeader(file, rows, columns))
+	{
+		printf("%s isn't a trace.\n", argv[1]);
+		fclose(file);
+		return 1;
+	}
+
+	const char *mode = argc > 2 ? argv[2] : "summary";
+	int status = 0;
+
+	if (!strcmp(mode, "summary"))
+		Summary(file, rows, columns);
+	else if (!strcmp(mode, "events"))
+		Events(file, rows, columns, Argument(argc, argv, 3, 1), Argument(argc, argv, 4, 0));
+	else if (!strcmp(mode, "board"))
+		Board(file, rows, columns, Argument(argc, argv, 3, 0));
+	else if (!strcmp(mode, "heat"))
+		Heat(file, rows, columns);
+	else
+	{
+		printf("Unknown mode %s.\n", mode);
+		status = 1;
+	}
+
+	fclose(file);
+	return status;
+}